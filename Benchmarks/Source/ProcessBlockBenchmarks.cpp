@@ -0,0 +1,208 @@
+/*
+    Google Benchmark suite for LazirkoAudioProcessor::processBlock.
+
+    Each benchmark runs one processor configuration (mode, channel layout, block
+    size, sample rate and the dephasing/damping amounts) on a fixed pseudo-random
+    programme signal and reports
+
+        ns/sample   wall time per sample frame
+        realtime    seconds of audio processed per second, i.e. the real-time factor
+
+    Every iteration copies a fresh block of input into the buffer first, so the
+    processor never sees its own output; that copy is included in the timings.
+    processBlockBenchmark<double> runs the processor in double precision, as
+    64-bit hosts do, and processBlockBenchmark<float, true> at Render quality.
+    silentBlockBenchmark times blocks of silence after the filter tails have died
+    away, the state of most instances in a large session.
+    Use --benchmark_format=json or --benchmark_out=<file> to keep results for
+    comparing commits.
+*/
+
+#include <JuceHeader.h>
+
+#include "../../Source/PluginProcessor.h"
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+
+namespace
+{
+    // Length of the looped input signal, in seconds
+    constexpr double inputSeconds = 1.0;
+
+    void setParameter(LazirkoAudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        auto* parameter = processor.getAPVTS().getParameter(parameterID);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    // Two detuned tones under broadband noise, with a short burst every 100 ms so the
+    // T/S mode has transients to separate
+    juce::AudioBuffer<float> makeInput(int numChannels, double sampleRate)
+    {
+        juce::AudioBuffer<float> input(numChannels, static_cast<int>(inputSeconds * sampleRate));
+        juce::Random random(1234);
+
+        const int burstPeriod = static_cast<int>(0.1 * sampleRate);
+        const float twoPi = juce::MathConstants<float>::twoPi;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* data = input.getWritePointer(ch);
+            const float frequency = 220.0f * (1.0f + 0.5f * static_cast<float>(ch));
+
+            for (int n = 0; n < input.getNumSamples(); ++n)
+            {
+                const float tone = 0.4f * std::sin(twoPi * frequency * static_cast<float>(n / sampleRate));
+                const float noise = 0.1f * (random.nextFloat() * 2.0f - 1.0f);
+                const float burst = (n % burstPeriod) < 64 ? 0.5f : 0.0f;
+                data[n] = tone + noise + burst;
+            }
+        }
+
+        return input;
+    }
+
+    template <typename SampleType, bool RenderQuality = false>
+    void processBlockBenchmark(benchmark::State& state)
+    {
+        const int mode = static_cast<int>(state.range(0));
+        const int numChannels = static_cast<int>(state.range(1));
+        const int blockSize = static_cast<int>(state.range(2));
+        const double sampleRate = static_cast<double>(state.range(3));
+        const float dephase = static_cast<float>(state.range(4)) / 100.0f;
+        const float damping = static_cast<float>(state.range(5)) / 100.0f;
+
+        LazirkoAudioProcessor processor;
+        setParameter(processor, "MODE", static_cast<float>(mode));
+        setParameter(processor, "DEPHASE", dephase);
+        setParameter(processor, "DAMPING", damping);
+        setParameter(processor, "QUALITY", RenderQuality ? 2.0f : 1.0f);
+        processor.setNoiseSeed(1);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+        layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+        if (! processor.setBusesLayout(layout))
+        {
+            state.SkipWithError("channel layout not supported");
+            return;
+        }
+
+        if constexpr (std::is_same_v<SampleType, double>)
+            processor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<SampleType> input;
+        input.makeCopyOf(makeInput(numChannels, sampleRate));
+        juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+        juce::MidiBuffer midi;
+
+        const int numInputBlocks = input.getNumSamples() / blockSize;
+        int inputBlock = 0;
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        for (auto _ : state)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                buffer.copyFrom(ch, 0, input, ch, inputBlock * blockSize, blockSize);
+
+            inputBlock = (inputBlock + 1) % numInputBlocks;
+
+            processor.processBlock(buffer, midi);
+            benchmark::DoNotOptimize(buffer.getWritePointer(0));
+            benchmark::ClobberMemory();
+        }
+
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - startTime;
+        processor.releaseResources();
+
+        const double samples = static_cast<double>(state.iterations()) * blockSize;
+        state.SetItemsProcessed(static_cast<int64_t>(samples));
+        state.counters["ns/sample"] = elapsed.count() / samples;
+        state.counters["realtime"] = samples / sampleRate / (elapsed.count() * 1e-9);
+    }
+
+    void silentBlockBenchmark(benchmark::State& state)
+    {
+        const int mode = static_cast<int>(state.range(0));
+        const int blockSize = static_cast<int>(state.range(1));
+        const double sampleRate = 48000.0;
+
+        LazirkoAudioProcessor processor;
+        setParameter(processor, "MODE", static_cast<float>(mode));
+        setParameter(processor, "DEPHASE", 0.5f);
+        setParameter(processor, "DAMPING", 0.5f);
+
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+
+        for (auto _ : state)
+        {
+            buffer.clear();
+            processor.processBlock(buffer, midi);
+            benchmark::DoNotOptimize(buffer.getWritePointer(0));
+            benchmark::ClobberMemory();
+        }
+
+        processor.releaseResources();
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * blockSize);
+    }
+
+    // Every mode, layout, block size and stage combination at 48 kHz, plus a sample
+    // rate sweep of each mode at a typical host setting
+    void processBlockArguments(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({ "mode", "channels", "block", "rate", "dephase", "damping" });
+
+        const int blockSizes[] = { 1, 16, 64, 256, 512, 1024, 4096, 8192 };
+        const int stageSettings[][2] = { { 0, 0 }, { 50, 0 }, { 0, 50 }, { 50, 50 } };
+        const int sampleRates[] = { 44100, 48000, 96000, 192000, 384000 };
+
+        for (int mode = 0; mode < 5; ++mode)
+            for (int channels = 1; channels <= 2; ++channels)
+                for (auto blockSize : blockSizes)
+                    for (auto& stages : stageSettings)
+                        benchmark->Args({ mode, channels, blockSize, 48000, stages[0], stages[1] });
+
+        for (int mode = 0; mode < 5; ++mode)
+            for (auto sampleRate : sampleRates)
+                if (sampleRate != 48000)
+                    benchmark->Args({ mode, 2, 512, sampleRate, 50, 50 });
+    }
+
+    // Double precision and Render quality at typical host settings
+    void typicalArguments(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({ "mode", "channels", "block", "rate", "dephase", "damping" });
+
+        for (int mode = 0; mode < 5; ++mode)
+            for (auto blockSize : { 64, 512, 4096 })
+                benchmark->Args({ mode, 2, blockSize, 48000, 50, 50 });
+    }
+}
+
+BENCHMARK_TEMPLATE(processBlockBenchmark, float)->Apply(processBlockArguments);
+BENCHMARK_TEMPLATE(processBlockBenchmark, double)->Apply(typicalArguments);
+BENCHMARK_TEMPLATE(processBlockBenchmark, float, true)->Apply(typicalArguments);
+BENCHMARK(silentBlockBenchmark)->ArgNames({ "mode", "block" })->ArgsProduct({ { 0, 1, 2, 3, 4 }, { 64, 512, 4096 } });
+
+int main(int argc, char** argv)
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
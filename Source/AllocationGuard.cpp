@@ -0,0 +1,126 @@
+#include "AllocationGuard.h"
+
+#if LAZIRKO_ALLOCATION_GUARD
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace AllocationGuard
+{
+    namespace
+    {
+        thread_local int noAllocationDepth = 0;
+        thread_local bool isReporting = false;
+        std::atomic<int> numViolations { 0 };
+    }
+
+    ScopedNoAllocation::ScopedNoAllocation() noexcept   { ++noAllocationDepth; }
+    ScopedNoAllocation::~ScopedNoAllocation() noexcept  { --noAllocationDepth; }
+
+    void checkAllocation() noexcept
+    {
+        // The assertion handler may allocate itself, so don't recurse into it
+        if (noAllocationDepth > 0 && ! isReporting)
+        {
+            isReporting = true;
+            numViolations.fetch_add(1, std::memory_order_relaxed);
+            jassertfalse; // Heap allocation on the audio thread
+            isReporting = false;
+        }
+    }
+
+    int getNumViolations() noexcept
+    {
+        return numViolations.load(std::memory_order_relaxed);
+    }
+}
+
+namespace
+{
+    void* guardedAllocate(std::size_t size)
+    {
+        AllocationGuard::checkAllocation();
+
+        if (void* ptr = std::malloc(size != 0 ? size : 1))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+
+    void* alignedAllocate(std::size_t size, std::align_val_t alignment) noexcept
+    {
+        AllocationGuard::checkAllocation();
+
+        const auto align = juce::jmax(sizeof(void*), static_cast<std::size_t>(alignment));
+
+       #if JUCE_WINDOWS
+        return _aligned_malloc(size != 0 ? size : 1, align);
+       #else
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, align, size != 0 ? size : 1) == 0 ? ptr : nullptr;
+       #endif
+    }
+
+    void alignedFree(void* ptr) noexcept
+    {
+       #if JUCE_WINDOWS
+        _aligned_free(ptr);
+       #else
+        std::free(ptr);
+       #endif
+    }
+
+    void* guardedAlignedAllocate(std::size_t size, std::align_val_t alignment)
+    {
+        if (void* ptr = alignedAllocate(size, alignment))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size)                                   { return guardedAllocate(size); }
+void* operator new[](std::size_t size)                                 { return guardedAllocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    AllocationGuard::checkAllocation();
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    AllocationGuard::checkAllocation();
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept                               { std::free(ptr); }
+void operator delete[](void* ptr) noexcept                             { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept                  { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept                { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept        { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept      { std::free(ptr); }
+
+// Over-aligned types (alignas beyond the default new alignment) come through these
+void* operator new(std::size_t size, std::align_val_t alignment)       { return guardedAlignedAllocate(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment)     { return guardedAlignedAllocate(size, alignment); }
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return alignedAllocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return alignedAllocate(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept                                   { alignedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept                                 { alignedFree(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept                      { alignedFree(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept                    { alignedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept            { alignedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept          { alignedFree(ptr); }
+
+#endif
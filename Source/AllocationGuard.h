@@ -0,0 +1,63 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Debug check for the real-time contract of the audio thread.
+
+    While a ScopedNoAllocation is alive on a thread, any heap allocation on that
+    same thread hits an assertion and is counted. Other threads are unaffected.
+    The check is only compiled in when LAZIRKO_ALLOCATION_GUARD is set. By default
+    that is debug builds only; the CMake option of the same name turns it on in
+    every configuration.
+
+    It works at two levels:
+    - AllocationGuard.cpp replaces the global operator new and delete, plain,
+      nothrow and aligned. That catches std::vector, std::function, make_unique
+      and the like, but not juce::HeapBlock or AudioBuffer::setSize, which call
+      malloc and realloc directly.
+    - AllocationGuardHooks.cpp replaces malloc, calloc, realloc and the aligned C
+      allocators on glibc, which catches those too. Only link it into executables
+      such as the test runner: inside a plugin binary the host's or the C
+      library's symbols take precedence, and the hooks would never run.
+
+    Neither catches allocations by the OS (thread creation, page faults on first
+    touch, mmap) or on platforms other than glibc below operator new. Replacing
+    operator new also changes it for the whole binary, which is why release
+    plugin builds leave the guard out.
+*/
+#ifndef LAZIRKO_ALLOCATION_GUARD
+ #define LAZIRKO_ALLOCATION_GUARD JUCE_DEBUG
+#endif
+
+namespace AllocationGuard
+{
+   #if LAZIRKO_ALLOCATION_GUARD
+    class ScopedNoAllocation
+    {
+    public:
+        ScopedNoAllocation() noexcept;
+        ~ScopedNoAllocation() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedNoAllocation)
+    };
+
+    /** Called by the replaced allocation functions; asserts inside a ScopedNoAllocation. */
+    void checkAllocation() noexcept;
+
+    /** Allocations caught inside a ScopedNoAllocation so far, on any thread. One
+        that passes through both levels, like operator new over malloc, counts twice. */
+    int getNumViolations() noexcept;
+   #else
+    class ScopedNoAllocation
+    {
+    public:
+        ScopedNoAllocation() noexcept {}
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedNoAllocation)
+    };
+
+    inline void checkAllocation() noexcept {}
+    inline int getNumViolations() noexcept { return 0; }
+   #endif
+}
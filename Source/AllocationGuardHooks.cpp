@@ -0,0 +1,66 @@
+#include "AllocationGuard.h"
+
+// Replaces the C allocators of glibc so that AllocationGuard also sees what goes
+// around operator new: juce::HeapBlock, AudioBuffer::setSize, realloc growth.
+// Defined in an executable, these take precedence over the C library's for every
+// caller in the process; see AllocationGuard.h for why plugins leave them out.
+#if LAZIRKO_ALLOCATION_GUARD && defined (__GLIBC__)
+
+#include <cerrno>
+#include <cstddef>
+
+extern "C"
+{
+    // glibc's own entry points, which the replacements forward to
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+
+    void* malloc(std::size_t size)
+    {
+        AllocationGuard::checkAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size)
+    {
+        AllocationGuard::checkAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, std::size_t size)
+    {
+        AllocationGuard::checkAllocation();
+        return __libc_realloc(ptr, size);
+    }
+
+    void* memalign(std::size_t alignment, std::size_t size)
+    {
+        AllocationGuard::checkAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(std::size_t alignment, std::size_t size)
+    {
+        AllocationGuard::checkAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, std::size_t alignment, std::size_t size)
+    {
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        AllocationGuard::checkAllocation();
+        void* ptr = __libc_memalign(alignment, size);
+
+        if (ptr == nullptr)
+            return ENOMEM;
+
+        *result = ptr;
+        return 0;
+    }
+}
+
+#endif
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "QuantumKernels.h"
+
+#include <array>
+#include <cmath>
+
+#if LAZIRKO_HAS_SSE2_KERNELS
+ #include <emmintrin.h>
+#endif
+
+#if LAZIRKO_HAS_NEON_KERNELS
+ #include <arm_neon.h>
+#endif
+
+/*
+    A bank of biquads that run side by side, one per SIMD lane.
+
+    Each filter has its own coefficients and state, but they all advance together
+    one sample at a time. So the L and R filters of a stereo pair, or the bands of
+    a crossover, share the instructions of one recursion instead of running as
+    separate serial chains. The filters use transposed direct form II: two state
+    values per filter and a short feedback path.
+
+    State and coefficients are double by default. At high sample rates a low
+    cutoff puts the poles close to z = 1, where float state loses precision.
+    StateType = float fits twice as many filters in a vector.
+*/
+namespace BiquadLanes
+{
+    /** Portable fallback: one filter per "vector". */
+    template <typename T>
+    struct Ops
+    {
+        using Vec = T;
+        static constexpr int width = 1;
+
+        static Vec load(const T* p)        { return *p; }
+        static void store(T* p, Vec v)     { *p = v; }
+        static Vec add(Vec a, Vec b)       { return a + b; }
+        static Vec sub(Vec a, Vec b)       { return a - b; }
+        static Vec mul(Vec a, Vec b)       { return a * b; }
+    };
+
+   #if LAZIRKO_HAS_SSE2_KERNELS
+    template <>
+    struct Ops<double>
+    {
+        using Vec = __m128d;
+        static constexpr int width = 2;
+
+        static Vec load(const double* p)    { return _mm_load_pd(p); }
+        static void store(double* p, Vec v) { _mm_store_pd(p, v); }
+        static Vec add(Vec a, Vec b)        { return _mm_add_pd(a, b); }
+        static Vec sub(Vec a, Vec b)        { return _mm_sub_pd(a, b); }
+        static Vec mul(Vec a, Vec b)        { return _mm_mul_pd(a, b); }
+    };
+
+    template <>
+    struct Ops<float>
+    {
+        using Vec = __m128;
+        static constexpr int width = 4;
+
+        static Vec load(const float* p)     { return _mm_load_ps(p); }
+        static void store(float* p, Vec v)  { _mm_store_ps(p, v); }
+        static Vec add(Vec a, Vec b)        { return _mm_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b)        { return _mm_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b)        { return _mm_mul_ps(a, b); }
+    };
+   #elif LAZIRKO_HAS_NEON_KERNELS
+    // 32-bit ARM has no double-precision vectors
+    #if defined (__aarch64__) || defined (_M_ARM64)
+    template <>
+    struct Ops<double>
+    {
+        using Vec = float64x2_t;
+        static constexpr int width = 2;
+
+        static Vec load(const double* p)    { return vld1q_f64(p); }
+        static void store(double* p, Vec v) { vst1q_f64(p, v); }
+        static Vec add(Vec a, Vec b)        { return vaddq_f64(a, b); }
+        static Vec sub(Vec a, Vec b)        { return vsubq_f64(a, b); }
+        static Vec mul(Vec a, Vec b)        { return vmulq_f64(a, b); }
+    };
+    #endif
+
+    template <>
+    struct Ops<float>
+    {
+        using Vec = float32x4_t;
+        static constexpr int width = 4;
+
+        static Vec load(const float* p)     { return vld1q_f32(p); }
+        static void store(float* p, Vec v)  { vst1q_f32(p, v); }
+        static Vec add(Vec a, Vec b)        { return vaddq_f32(a, b); }
+        static Vec sub(Vec a, Vec b)        { return vsubq_f32(a, b); }
+        static Vec mul(Vec a, Vec b)        { return vmulq_f32(a, b); }
+    };
+   #endif
+}
+
+template <int NumFilters, typename StateType = double>
+class BiquadBank
+{
+public:
+    BiquadBank() noexcept
+    {
+        for (int filter = 0; filter < NumFilters; ++filter)
+            setCoefficients(filter, 1.0, 0.0, 0.0, 0.0, 0.0);
+
+        reset();
+    }
+
+    /** Sets the coefficients of one filter, normalised so that a0 = 1. */
+    void setCoefficients(int filter, double b0, double b1, double b2, double a1, double a2) noexcept
+    {
+        const auto lane = static_cast<size_t>(filter);
+        coefficients[0][lane] = static_cast<StateType>(b0);
+        coefficients[1][lane] = static_cast<StateType>(b1);
+        coefficients[2][lane] = static_cast<StateType>(b2);
+        coefficients[3][lane] = static_cast<StateType>(a1);
+        coefficients[4][lane] = static_cast<StateType>(a2);
+    }
+
+    void reset() noexcept
+    {
+        state[0].fill(StateType());
+        state[1].fill(StateType());
+    }
+
+    /** True when no filter holds state above threshold, so that on silent input
+        every output has died away. */
+    bool hasDecayed(double threshold) const noexcept
+    {
+        for (auto& values : state)
+            for (auto value : values)
+                if (std::abs(static_cast<double>(value)) > threshold)
+                    return false;
+
+        return true;
+    }
+
+    /** Runs filter k over numSamples of inputs[k] and writes outputs[k]. An output may
+        be the same array as its input. Only the first numFilters filters run, so a
+        bank sized for the largest case can serve smaller ones; the others keep
+        their state. Inputs and outputs can be float or double independently of
+        the state type. */
+    template <typename InputType, typename OutputType>
+    void process(const InputType* const* inputs, OutputType* const* outputs, int numSamples,
+                 int numFilters = NumFilters) noexcept
+    {
+        using V = typename Ops::Vec;
+
+        jassert(numFilters > 0 && numFilters <= NumFilters);
+        const int numActiveVectors = (numFilters + width - 1) / width;
+
+        // Coefficients and state stay in registers for the whole block
+        V b0[numVectors], b1[numVectors], b2[numVectors], a1[numVectors], a2[numVectors];
+        V s1[numVectors], s2[numVectors];
+
+        for (int v = 0; v < numActiveVectors; ++v)
+        {
+            const size_t offset = static_cast<size_t>(v * width);
+            b0[v] = Ops::load(coefficients[0].data() + offset);
+            b1[v] = Ops::load(coefficients[1].data() + offset);
+            b2[v] = Ops::load(coefficients[2].data() + offset);
+            a1[v] = Ops::load(coefficients[3].data() + offset);
+            a2[v] = Ops::load(coefficients[4].data() + offset);
+            s1[v] = Ops::load(state[0].data() + offset);
+            s2[v] = Ops::load(state[1].data() + offset);
+        }
+
+        // Unused lanes of the last vector see silence
+        alignas(16) StateType x[numLanes] = {};
+        alignas(16) StateType y[numLanes];
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            for (int filter = 0; filter < numFilters; ++filter)
+                x[filter] = static_cast<StateType>(inputs[filter][n]);
+
+            for (int v = 0; v < numActiveVectors; ++v)
+            {
+                const V in = Ops::load(x + v * width);
+                const V out = Ops::add(Ops::mul(b0[v], in), s1[v]);
+
+                s1[v] = Ops::add(Ops::sub(Ops::mul(b1[v], in), Ops::mul(a1[v], out)), s2[v]);
+                s2[v] = Ops::sub(Ops::mul(b2[v], in), Ops::mul(a2[v], out));
+
+                Ops::store(y + v * width, out);
+            }
+
+            for (int filter = 0; filter < numFilters; ++filter)
+                outputs[filter][n] = static_cast<OutputType>(y[filter]);
+        }
+
+        for (int v = 0; v < numActiveVectors; ++v)
+        {
+            const size_t offset = static_cast<size_t>(v * width);
+            Ops::store(state[0].data() + offset, s1[v]);
+            Ops::store(state[1].data() + offset, s2[v]);
+        }
+    }
+
+private:
+    using Ops = BiquadLanes::Ops<StateType>;
+
+    static constexpr int width = Ops::width;
+    static constexpr int numVectors = (NumFilters + width - 1) / width;
+    static constexpr int numLanes = numVectors * width;
+
+    // b0, b1, b2, a1, a2 and the two state values, one lane per filter
+    alignas(16) std::array<std::array<StateType, numLanes>, 5> coefficients {};
+    alignas(16) std::array<std::array<StateType, numLanes>, 2> state {};
+};
@@ -0,0 +1,264 @@
+#include "CpuProfiler.h"
+
+#include <cmath>
+
+#if defined (__x86_64__) || defined (__i386__) || defined (_M_X64) || defined (_M_IX86)
+ #define LAZIRKO_CYCLE_COUNTER_TSC 1
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#elif defined (__aarch64__) && ! JUCE_MSVC
+ #define LAZIRKO_CYCLE_COUNTER_CNTVCT 1
+#endif
+
+const char* CpuProfiler::getStageName(Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case wholeBlock:     return "processBlock";
+        case modeProcessor:  return "mode";
+        case quantumChannel: return "channel";
+        case numStages:      break;
+    }
+
+    return "";
+}
+
+std::uint64_t CpuProfiler::readCycleCounter() noexcept
+{
+   #if LAZIRKO_CYCLE_COUNTER_TSC
+    return static_cast<std::uint64_t>(__rdtsc());
+   #elif LAZIRKO_CYCLE_COUNTER_CNTVCT
+    std::uint64_t value;
+    asm volatile ("mrs %0, cntvct_el0" : "=r" (value));
+    return value;
+   #else
+    return static_cast<std::uint64_t>(juce::Time::getHighResolutionTicks());
+   #endif
+}
+
+double CpuProfiler::getCyclesPerSecond()
+{
+    static const double cyclesPerSecond = []
+    {
+       #if LAZIRKO_CYCLE_COUNTER_TSC || LAZIRKO_CYCLE_COUNTER_CNTVCT
+        // Spin rather than sleep, so that a power-saving core doesn't skew the count
+        const auto ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCycles = readCycleCounter();
+        auto endTicks = startTicks;
+
+        while (static_cast<double>(endTicks - startTicks) < 0.02 * ticksPerSecond)
+            endTicks = juce::Time::getHighResolutionTicks();
+
+        const auto cycles = static_cast<double>(readCycleCounter() - startCycles);
+        return cycles * ticksPerSecond / static_cast<double>(endTicks - startTicks);
+       #else
+        return static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+       #endif
+    }();
+
+    return cyclesPerSecond;
+}
+
+void CpuProfiler::setEnabled(bool shouldBeEnabled)
+{
+    // Measure the counter here, off the audio thread
+    if (shouldBeEnabled)
+        getCyclesPerSecond();
+
+    enabled.store(shouldBeEnabled, std::memory_order_relaxed);
+}
+
+int CpuProfiler::getBin(std::uint64_t value) noexcept
+{
+    // Below one octave of sub-bins every value has its own bin
+    if (value < static_cast<std::uint64_t>(binsPerOctave))
+        return static_cast<int>(value);
+
+    int octave = 0;
+    while ((value >> octave) > 1)
+        ++octave;
+
+    // The three bits below the leading one pick the sub-bin
+    const auto subBin = static_cast<int>((value >> (octave - 3)) & (binsPerOctave - 1));
+    return octave * binsPerOctave + subBin;
+}
+
+double CpuProfiler::getBinCentre(int bin) noexcept
+{
+    if (bin < binsPerOctave)
+        return static_cast<double>(bin);
+
+    const int octave = bin / binsPerOctave;
+    const int subBin = bin % binsPerOctave;
+    return std::ldexp(static_cast<double>(binsPerOctave + subBin) + 0.5, octave - 3);
+}
+
+void CpuProfiler::record(Stage stage, std::uint64_t cycles, int numSamples) noexcept
+{
+    auto& counts = stages[static_cast<size_t>(stage)];
+
+    counts.count.fetch_add(1, std::memory_order_relaxed);
+    counts.durations[static_cast<size_t>(getBin(cycles))].fetch_add(1, std::memory_order_relaxed);
+
+    auto previousMax = counts.maxCycles.load(std::memory_order_relaxed);
+    while (cycles > previousMax && ! counts.maxCycles.compare_exchange_weak(previousMax, cycles, std::memory_order_relaxed))
+        ;
+
+    // The budget is the length of the audio processed, in counter ticks
+    const double rate = sampleRate.load(std::memory_order_relaxed);
+
+    if (rate <= 0.0 || numSamples <= 0)
+        return;
+
+    const double budget = getCyclesPerSecond() * numSamples / rate;
+
+    const auto percent = static_cast<float>(100.0 * static_cast<double>(cycles) / budget);
+    const auto budgetUnits = static_cast<std::uint64_t>(juce::jmin(1.0e18, static_cast<double>(percent) * budgetUnitsPerPercent));
+    counts.budgetShares[static_cast<size_t>(getBin(budgetUnits))].fetch_add(1, std::memory_order_relaxed);
+
+    if (percent >= static_cast<float>(nearDeadlinePercent))
+        counts.nearDeadline.fetch_add(1, std::memory_order_relaxed);
+
+    if (percent >= 100.0f)
+        counts.overDeadline.fetch_add(1, std::memory_order_relaxed);
+
+    auto previousMaxBudget = counts.maxBudget.load(std::memory_order_relaxed);
+    while (percent > previousMaxBudget && ! counts.maxBudget.compare_exchange_weak(previousMaxBudget, percent, std::memory_order_relaxed))
+        ;
+}
+
+void CpuProfiler::reset() noexcept
+{
+    for (auto& counts : stages)
+    {
+        for (auto& bin : counts.durations)
+            bin.store(0, std::memory_order_relaxed);
+
+        for (auto& bin : counts.budgetShares)
+            bin.store(0, std::memory_order_relaxed);
+
+        counts.count.store(0, std::memory_order_relaxed);
+        counts.maxCycles.store(0, std::memory_order_relaxed);
+        counts.nearDeadline.store(0, std::memory_order_relaxed);
+        counts.overDeadline.store(0, std::memory_order_relaxed);
+        counts.maxBudget.store(0.0f, std::memory_order_relaxed);
+    }
+}
+
+void CpuProfiler::addFrom(const CpuProfiler& other) noexcept
+{
+    for (size_t s = 0; s < stages.size(); ++s)
+    {
+        auto& counts = stages[s];
+        const auto& otherCounts = other.stages[s];
+
+        for (size_t bin = 0; bin < counts.durations.size(); ++bin)
+            counts.durations[bin].fetch_add(otherCounts.durations[bin].load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        for (size_t bin = 0; bin < counts.budgetShares.size(); ++bin)
+            counts.budgetShares[bin].fetch_add(otherCounts.budgetShares[bin].load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        counts.count.fetch_add(otherCounts.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        counts.nearDeadline.fetch_add(otherCounts.nearDeadline.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        counts.overDeadline.fetch_add(otherCounts.overDeadline.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        counts.maxCycles.store(juce::jmax(counts.maxCycles.load(std::memory_order_relaxed),
+                                          otherCounts.maxCycles.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+        counts.maxBudget.store(juce::jmax(counts.maxBudget.load(std::memory_order_relaxed),
+                                          otherCounts.maxBudget.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+    }
+}
+
+namespace
+{
+    // The index of the bin holding the sample of the given rank, counting from 1
+    template <size_t NumBins>
+    int findBinOfRank(const std::array<std::atomic<std::uint64_t>, NumBins>& bins, std::uint64_t rank) noexcept
+    {
+        std::uint64_t seen = 0;
+
+        for (size_t bin = 0; bin < NumBins; ++bin)
+        {
+            seen += bins[bin].load(std::memory_order_relaxed);
+
+            if (seen >= rank)
+                return static_cast<int>(bin);
+        }
+
+        return static_cast<int>(NumBins) - 1;
+    }
+
+    template <size_t NumBins>
+    std::uint64_t sumBins(const std::array<std::atomic<std::uint64_t>, NumBins>& bins) noexcept
+    {
+        std::uint64_t sum = 0;
+
+        for (const auto& bin : bins)
+            sum += bin.load(std::memory_order_relaxed);
+
+        return sum;
+    }
+
+    std::uint64_t getRank(std::uint64_t count, double quantile) noexcept
+    {
+        return juce::jmax(static_cast<std::uint64_t>(1), static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(count))));
+    }
+}
+
+CpuProfiler::StageReport CpuProfiler::getReport(Stage stage) const noexcept
+{
+    const auto& counts = stages[static_cast<size_t>(stage)];
+    const double secondsPerCycle = 1.0 / getCyclesPerSecond();
+
+    StageReport report;
+    report.count = counts.count.load(std::memory_order_relaxed);
+    report.nearDeadline = counts.nearDeadline.load(std::memory_order_relaxed);
+    report.overDeadline = counts.overDeadline.load(std::memory_order_relaxed);
+    report.maxSeconds = static_cast<double>(counts.maxCycles.load(std::memory_order_relaxed)) * secondsPerCycle;
+    report.maxBudget = static_cast<double>(counts.maxBudget.load(std::memory_order_relaxed));
+
+    // The bins are read one by one while recorders may still add to them, so rank
+    // against what the bins hold rather than the separate count
+    if (const auto numDurations = sumBins(counts.durations); numDurations > 0)
+    {
+        report.p50Seconds = getBinCentre(findBinOfRank(counts.durations, getRank(numDurations, 0.5))) * secondsPerCycle;
+        report.p99Seconds = getBinCentre(findBinOfRank(counts.durations, getRank(numDurations, 0.99))) * secondsPerCycle;
+    }
+
+    if (const auto numShares = sumBins(counts.budgetShares); numShares > 0)
+    {
+        report.p50Budget = getBinCentre(findBinOfRank(counts.budgetShares, getRank(numShares, 0.5))) / budgetUnitsPerPercent;
+        report.p99Budget = getBinCentre(findBinOfRank(counts.budgetShares, getRank(numShares, 0.99))) / budgetUnitsPerPercent;
+    }
+
+    return report;
+}
+
+juce::String CpuProfiler::getReportText() const
+{
+    juce::String text;
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        const auto stage = static_cast<Stage>(s);
+        const auto report = getReport(stage);
+
+        text << juce::String(getStageName(stage)).paddedRight(' ', 14)
+             << "calls " << juce::String(static_cast<juce::int64>(report.count))
+             << "  time p50 " << juce::String(report.p50Seconds * 1.0e6, 1) << " us"
+             << " p99 " << juce::String(report.p99Seconds * 1.0e6, 1) << " us"
+             << " max " << juce::String(report.maxSeconds * 1.0e6, 1) << " us"
+             << "  budget p50 " << juce::String(report.p50Budget, 2) << "%"
+             << " p99 " << juce::String(report.p99Budget, 2) << "%"
+             << " max " << juce::String(report.maxBudget, 2) << "%"
+             << "  over " << juce::String(static_cast<int>(nearDeadlinePercent)) << "% "
+             << juce::String(static_cast<juce::int64>(report.nearDeadline))
+             << "  over 100% " << juce::String(static_cast<juce::int64>(report.overDeadline))
+             << juce::newLine;
+    }
+
+    return text;
+}
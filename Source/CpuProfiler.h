@@ -0,0 +1,131 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*
+    Cost of the audio processing against its real-time budget.
+
+    The instrumented stages time themselves with the CPU's cycle counter and add
+    the result to lock-free histograms: one of durations on a logarithmic scale
+    and one of the share of the real-time budget used, where the budget is the
+    length of the audio processed. Recording is a few relaxed atomic adds and
+    takes no lock, so the audio thread and the band workers can all record at
+    once. Readers get percentiles from the histograms, to within one bin: both are
+    logarithmic, eight bins per octave, so to within about 9 %.
+
+    Disabled, a ScopedTimer costs one relaxed load and a branch. Enabling the
+    profiler for the first time in a process measures the cycle counter's rate
+    against the system clock, which blocks the calling thread for about 20 ms.
+*/
+class CpuProfiler
+{
+public:
+    enum Stage
+    {
+        wholeBlock,         // processBlock
+        modeProcessor,      // one mode processor call, on a sub-block
+        quantumChannel,     // applyQuantumChannel, on one chunk of one state or band
+        numStages
+    };
+
+    CpuProfiler() = default;
+
+    static const char* getStageName(Stage stage) noexcept;
+
+    /** The CPU's free-running counter: the TSC on x86, the virtual counter on 64-bit
+        ARM, JUCE's high-resolution ticks elsewhere. */
+    static std::uint64_t readCycleCounter() noexcept;
+
+    /** Counter ticks per second; measured on the first call, which setEnabled(true)
+        makes before anything records. */
+    static double getCyclesPerSecond();
+
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const noexcept  { return enabled.load(std::memory_order_relaxed); }
+
+    /** The rate the budget is computed at; call before processing. */
+    void setSampleRate(double newSampleRate) noexcept  { sampleRate.store(newSampleRate, std::memory_order_relaxed); }
+
+    /** Adds one call of a stage that processed numSamples in the given cycles. */
+    void record(Stage stage, std::uint64_t cycles, int numSamples) noexcept;
+
+    /** Forgets everything recorded. Racing recorders may leave a count behind. */
+    void reset() noexcept;
+
+    /** Adds another profiler's counts, as when several renderers share one report. */
+    void addFrom(const CpuProfiler& other) noexcept;
+
+    struct StageReport
+    {
+        std::uint64_t count = 0;
+        double p50Seconds = 0.0, p99Seconds = 0.0, maxSeconds = 0.0;
+        double p50Budget = 0.0, p99Budget = 0.0, maxBudget = 0.0;     // percent of real time
+        std::uint64_t nearDeadline = 0;     // calls that used more than nearDeadlinePercent
+        std::uint64_t overDeadline = 0;     // calls that used more than all of it
+    };
+
+    static constexpr double nearDeadlinePercent = 70.0;
+
+    StageReport getReport(Stage stage) const noexcept;
+
+    /** One line per stage, for logs and the renderer's --profile file. */
+    juce::String getReportText() const;
+
+    /** Times its own lifetime as one call of a stage, if the profiler is enabled. */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(CpuProfiler& profilerToUse, Stage stageToTime, int numSamplesProcessed) noexcept
+            : profiler(profilerToUse.isEnabled() ? &profilerToUse : nullptr),
+              stage(stageToTime),
+              numSamples(numSamplesProcessed),
+              start(profiler != nullptr ? readCycleCounter() : 0)
+        {
+        }
+
+        ~ScopedTimer() noexcept
+        {
+            if (profiler != nullptr)
+                profiler->record(stage, readCycleCounter() - start, numSamples);
+        }
+
+    private:
+        CpuProfiler* profiler;
+        Stage stage;
+        int numSamples;
+        std::uint64_t start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+private:
+    // Durations are binned in cycles and budget shares in millionths of the budget,
+    // eight bins per octave over the whole 64-bit range
+    static constexpr int binsPerOctave = 8;
+    static constexpr int numBins = 64 * binsPerOctave;
+    static constexpr double budgetUnitsPerPercent = 1.0e4;
+
+    struct StageCounts
+    {
+        std::array<std::atomic<std::uint64_t>, numBins> durations {};
+        std::array<std::atomic<std::uint64_t>, numBins> budgetShares {};
+        std::atomic<std::uint64_t> count { 0 };
+        std::atomic<std::uint64_t> maxCycles { 0 };
+        std::atomic<std::uint64_t> nearDeadline { 0 };
+        std::atomic<std::uint64_t> overDeadline { 0 };
+        std::atomic<float> maxBudget { 0.0f };
+    };
+
+    static int getBin(std::uint64_t value) noexcept;
+    static double getBinCentre(int bin) noexcept;
+
+    std::array<StageCounts, numStages> stages;
+    std::atomic<bool> enabled { false };
+    std::atomic<double> sampleRate { 0.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CpuProfiler)
+};
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "BiquadBank.h"
+
+#include <array>
+#include <cmath>
+
+/*
+    Momentary loudness (ITU-R BS.1770) of the signals going into and out of the
+    channel, for the auto-gain.
+
+    Every signal goes through the K-weighting filters, a high shelf and a high
+    pass, so that loudness follows what the ear hears rather than plain RMS; the
+    harmonics that damping adds count for more than their energy. The filters of
+    all signals run side by side, one per SIMD lane as in BiquadBank, in direct
+    form I: the recursion through the last output is then one multiply and one
+    subtract long, and only the sum of squares of the result is kept. State,
+    coefficients and sums are double, like the other filters: the 38 Hz high
+    pass has its poles next to z = 1, where float state loses precision and its
+    rounding takes long to die out.
+
+    The window is the 400 ms of momentary loudness, in hops of hopSeconds. Every
+    signal keeps the sum of squares of each hop in a ring and a running total over
+    the ring; a completed hop replaces the oldest one in the total. Hops are counted
+    in samples of the stream, not from the start of a block, so the estimate and
+    the moments it changes are the same at any host block size, and the work per
+    sample is the same too. The totals are rebuilt from the rings once per lap, so
+    rounding in the running subtraction cannot build up. Hops and laps start at
+    fixed stream positions, so a window reset part way through a stream, as in a
+    chunk of a parallel render, holds the same sums as one that has run since the
+    start once it has seen a full window.
+*/
+class LoudnessWindow
+{
+public:
+    static constexpr int maxSignals = 2;
+    static constexpr int numHops = 80;
+    static constexpr double hopSeconds = 0.005;     // 400 ms window
+
+    void prepare(double sampleRate) noexcept
+    {
+        hopLength = juce::jmax(1, juce::roundToInt(sampleRate * hopSeconds));
+
+        // The K-weighting filters of BS.1770 for any sample rate: the published 48 kHz
+        // coefficients come from these analog prototypes
+        const double pi = juce::MathConstants<double>::pi;
+
+        {
+            const double k = std::tan(pi * 1681.974450955533 / sampleRate);
+            const double q = 0.7071752369554196;
+            const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+            const double vb = std::pow(vh, 0.4996667741545416);
+            const double a0 = 1.0 + k / q + k * k;
+
+            shelfCoefficients[0].fill((vh + vb * k / q + k * k) / a0);
+            shelfCoefficients[1].fill(2.0 * (k * k - vh) / a0);
+            shelfCoefficients[2].fill((vh - vb * k / q + k * k) / a0);
+            shelfCoefficients[3].fill(2.0 * (k * k - 1.0) / a0);
+            shelfCoefficients[4].fill((1.0 - k / q + k * k) / a0);
+        }
+
+        {
+            const double k = std::tan(pi * 38.13547087602444 / sampleRate);
+            const double q = 0.5003270373238773;
+            const double a0 = 1.0 + k / q + k * k;
+
+            // The numerator is 1, -2, 1
+            highPassCoefficients[0].fill(2.0 * (k * k - 1.0) / a0);
+            highPassCoefficients[1].fill((1.0 - k / q + k * k) / a0);
+        }
+
+        reset();
+    }
+
+    /** Empties the window, which then goes on from the given stream position. */
+    void reset(juce::uint64 streamPosition = 0) noexcept
+    {
+        clear();
+        hopPosition = static_cast<int>(streamPosition % static_cast<juce::uint64>(hopLength));
+        ringIndex = static_cast<int>((streamPosition / static_cast<juce::uint64>(hopLength)) % numHops);
+    }
+
+    int getSamplesToHopEnd() const noexcept  { return hopLength - hopPosition; }
+
+    /** Adds samples [startSample, startSample + numSamples) of each input and output
+        signal; numSamples must not go past the end of the hop. Returns true if this
+        completed a hop and the estimate has moved on. */
+    template <int NumSignals>
+    bool add(const float* const* inputs, const float* const* outputs, int startSample, int numSamples) noexcept
+    {
+        static_assert(NumSignals > 0 && NumSignals <= maxSignals);
+        jassert(numSamples <= getSamplesToHopEnd());
+
+        // The window only makes sense for one set of signals
+        if (NumSignals != numSignals)
+        {
+            clear();
+            numSignals = NumSignals;
+        }
+
+        // Lanes alternate input and output, so one signal uses the first two
+        constexpr int numActiveLanes = 2 * NumSignals;
+
+        const float* sources[numLanes];
+
+        for (int s = 0; s < NumSignals; ++s)
+        {
+            sources[2 * s] = inputs[s] + startSample;
+            sources[2 * s + 1] = outputs[s] + startSample;
+        }
+
+        // The squares add straight into the hop's sums, so the rounding is the same
+        // however the hop was split
+        addWeightedSquares<numActiveLanes>(sources, numSamples);
+        hopPosition += numSamples;
+
+        if (hopPosition < hopLength)
+            return false;
+
+        for (size_t lane = 0; lane < totals.size(); ++lane)
+        {
+            totals[lane] += currentHop[lane] - hopSums[lane][static_cast<size_t>(ringIndex)];
+            hopSums[lane][static_cast<size_t>(ringIndex)] = currentHop[lane];
+        }
+
+        currentHop.fill(0.0);
+
+        hopPosition = 0;
+
+        if (++ringIndex == numHops)
+        {
+            ringIndex = 0;
+
+            for (size_t lane = 0; lane < totals.size(); ++lane)
+            {
+                double sum = 0.0;
+                for (double hopSum : hopSums[lane])
+                    sum += hopSum;
+
+                totals[lane] = sum;
+            }
+        }
+
+        return true;
+    }
+
+    /** The gain that brings the output to the loudness of the input, limited to
+        +-20 dB. The channels' mean squares add up, as in BS.1770. Unity while
+        either side is below the -70 LKFS absolute gate. */
+    float getGainCompensation() const noexcept
+    {
+        double input = 0.0, output = 0.0;
+
+        for (int s = 0; s < numSignals; ++s)
+        {
+            input += juce::jmax(0.0, totals[static_cast<size_t>(2 * s)]);
+            output += juce::jmax(0.0, totals[static_cast<size_t>(2 * s + 1)]);
+        }
+
+        // -0.691 + 10 log10(z) > -70, with z the summed mean square
+        const double windowLength = static_cast<double>(hopLength) * numHops;
+        const double gate = std::pow(10.0, (-70.0 + 0.691) / 10.0) * windowLength;
+
+        if (input > gate && output > gate)
+            return juce::jlimit(0.1f, 10.0f, static_cast<float>(std::sqrt(input / output)));
+
+        return 1.0f;
+    }
+
+private:
+    static constexpr int numLanes = 2 * maxSignals;
+
+    using Ops = BiquadLanes::Ops<double>;
+    static constexpr int width = Ops::width;
+    static constexpr int numVectors = (numLanes + width - 1) / width;
+    static constexpr int numPaddedLanes = numVectors * width;
+
+    // Empties the filters and sums, but stays where it is in the stream
+    void clear() noexcept
+    {
+        for (auto& values : history)
+            values.fill(0.0);
+
+        for (auto& ring : hopSums)
+            ring.fill(0.0);
+
+        totals.fill(0.0);
+        currentHop.fill(0.0);
+    }
+
+    // The lane count is fixed at compile time so that gathering one sample of every
+    // lane into a vector unrolls
+    template <int NumActiveLanes>
+    void addWeightedSquares(const float* const* sources, int numSamples) noexcept
+    {
+        using V = Ops::Vec;
+
+        constexpr int numActiveVectors = (NumActiveLanes + width - 1) / width;
+
+        V sb0[numVectors], sb1[numVectors], sb2[numVectors], sa1[numVectors], sa2[numVectors];
+        V ha1[numVectors], ha2[numVectors];
+        V x1[numVectors], x2[numVectors], y1[numVectors], y2[numVectors], z1[numVectors], z2[numVectors];
+        V sums[numVectors];
+
+        // All vectors load and store, so that none is left unset; only the active ones run
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const size_t offset = static_cast<size_t>(v * width);
+            sb0[v] = Ops::load(shelfCoefficients[0].data() + offset);
+            sb1[v] = Ops::load(shelfCoefficients[1].data() + offset);
+            sb2[v] = Ops::load(shelfCoefficients[2].data() + offset);
+            sa1[v] = Ops::load(shelfCoefficients[3].data() + offset);
+            sa2[v] = Ops::load(shelfCoefficients[4].data() + offset);
+            ha1[v] = Ops::load(highPassCoefficients[0].data() + offset);
+            ha2[v] = Ops::load(highPassCoefficients[1].data() + offset);
+            x1[v] = Ops::load(history[0].data() + offset);
+            x2[v] = Ops::load(history[1].data() + offset);
+            y1[v] = Ops::load(history[2].data() + offset);
+            y2[v] = Ops::load(history[3].data() + offset);
+            z1[v] = Ops::load(history[4].data() + offset);
+            z2[v] = Ops::load(history[5].data() + offset);
+            sums[v] = Ops::load(currentHop.data() + offset);
+        }
+
+        // Unused lanes of the last vector repeat the active ones, so that every lane of
+        // a vector is written before it loads; their sums are never read
+        constexpr int numGatheredLanes = numActiveVectors * width;
+        const float* lanes[numPaddedLanes];
+
+        for (int lane = 0; lane < numGatheredLanes; ++lane)
+            lanes[lane] = sources[lane % NumActiveLanes];
+
+        alignas(16) double x[numPaddedLanes] = {};
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            for (int lane = 0; lane < numGatheredLanes; ++lane)
+                x[lane] = static_cast<double>(lanes[lane][n]);
+
+            for (int v = 0; v < numActiveVectors; ++v)
+            {
+                const V in = Ops::load(x + v * width);
+
+                // Everything but the last output is known early and stays off the recursion
+                const V shelfFeed = Ops::sub(Ops::add(Ops::add(Ops::mul(sb0[v], in), Ops::mul(sb1[v], x1[v])),
+                                                      Ops::mul(sb2[v], x2[v])),
+                                             Ops::mul(sa2[v], y2[v]));
+                const V shelved = Ops::sub(shelfFeed, Ops::mul(sa1[v], y1[v]));
+
+                const V highPassFeed = Ops::sub(Ops::add(Ops::sub(shelved, Ops::add(y1[v], y1[v])), y2[v]),
+                                                Ops::mul(ha2[v], z2[v]));
+                const V weighted = Ops::sub(highPassFeed, Ops::mul(ha1[v], z1[v]));
+
+                x2[v] = x1[v];
+                x1[v] = in;
+                y2[v] = y1[v];
+                y1[v] = shelved;
+                z2[v] = z1[v];
+                z1[v] = weighted;
+
+                sums[v] = Ops::add(sums[v], Ops::mul(weighted, weighted));
+            }
+        }
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const size_t offset = static_cast<size_t>(v * width);
+            Ops::store(history[0].data() + offset, x1[v]);
+            Ops::store(history[1].data() + offset, x2[v]);
+            Ops::store(history[2].data() + offset, y1[v]);
+            Ops::store(history[3].data() + offset, y2[v]);
+            Ops::store(history[4].data() + offset, z1[v]);
+            Ops::store(history[5].data() + offset, z2[v]);
+            Ops::store(currentHop.data() + offset, sums[v]);
+        }
+    }
+
+    // b0, b1, b2, a1, a2 of the shelf and a1, a2 of the high pass, the same in every
+    // lane; then the last two inputs, shelf outputs and high-pass outputs per lane
+    alignas(16) std::array<std::array<double, numPaddedLanes>, 5> shelfCoefficients {};
+    alignas(16) std::array<std::array<double, numPaddedLanes>, 2> highPassCoefficients {};
+    alignas(16) std::array<std::array<double, numPaddedLanes>, 6> history {};
+
+    // Per lane: the sums of squares of the last numHops hops, their total and the
+    // hop being filled
+    std::array<std::array<double, numHops>, numPaddedLanes> hopSums {};
+    std::array<double, numPaddedLanes> totals {};
+    alignas(16) std::array<double, numPaddedLanes> currentHop {};
+
+    int numSignals = 0;
+    int hopLength = 1;
+    int hopPosition = 0;
+    int ringIndex = 0;
+};
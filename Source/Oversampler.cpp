@@ -0,0 +1,554 @@
+#include "Oversampler.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Images are designed to be this far down, in every stage
+    constexpr double stopbandAttenuationDb = 100.0;
+
+    // The passband edge as a fraction of the native sample rate
+    constexpr double passbandEdge = 0.45;
+
+    // Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 64 && term > 1.0e-12 * sum; ++k)
+        {
+            const double half = x / (2.0 * k);
+            term *= half * half;
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    // The series of the elliptic modular functions in the IIR half-band design
+    double iirNumeratorSum(double q, int order, int index)
+    {
+        const double pi = juce::MathConstants<double>::pi;
+        double sum = 0.0, term = 1.0;
+
+        for (int i = 0; std::abs(term) > 1.0e-100; ++i)
+        {
+            term = std::pow(q, i * (i + 1)) * std::sin((i * 2 + 1) * index * pi / order) * ((i % 2) == 0 ? 1.0 : -1.0);
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    double iirDenominatorSum(double q, int order, int index)
+    {
+        const double pi = juce::MathConstants<double>::pi;
+        double sum = 0.0, term = 1.0;
+
+        for (int i = 1; std::abs(term) > 1.0e-100; ++i)
+        {
+            term = std::pow(q, i * i) * std::cos(i * 2 * index * pi / order) * ((i % 2) == 0 ? 1.0 : -1.0);
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    // Kaiser's estimate of the FIR half-band length, rounded up to 4m + 3 taps so that
+    // the half-band has odd taps at both ends and its centre at an odd index; returns m
+    int getFirHalfLength(double transition, double attenuationDb)
+    {
+        const double pi = juce::MathConstants<double>::pi;
+        const double estimate = (attenuationDb - 7.95) / (2.285 * 2.0 * pi * transition) + 1.0;
+        return juce::jmax(0, static_cast<int>(std::ceil((estimate - 3.0) / 4.0)));
+    }
+
+    // The elliptic IIR half-band: the transition sets the modulus k and nome q, the
+    // attenuation the order
+    struct IirDesign
+    {
+        double k = 0.0, q = 0.0;
+        int order = 1;
+        int numCoefficients = 1;
+    };
+
+    IirDesign getIirDesign(double transition, double attenuationDb)
+    {
+        const double pi = juce::MathConstants<double>::pi;
+        IirDesign design;
+
+        design.k = std::tan((1.0 - transition * 2.0) * pi / 4.0);
+        design.k *= design.k;
+
+        const double kRoot = std::pow(1.0 - design.k * design.k, 0.25);
+        const double e = 0.5 * (1.0 - kRoot) / (1.0 + kRoot);
+        const double e4 = e * e * e * e;
+        design.q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+
+        const double attenuation = std::pow(10.0, -attenuationDb / 10.0);
+        const double a = attenuation / (1.0 - attenuation);
+        design.order = static_cast<int>(std::ceil(std::log(a * a / 16.0) / std::log(design.q))) | 1;
+        design.numCoefficients = juce::jmax(1, (design.order - 1) / 2);
+        return design;
+    }
+
+    // The all-pass coefficient of one section; they alternate between the two chains
+    double getIirCoefficient(const IirDesign& design, int index)
+    {
+        const double numerator = iirNumeratorSum(design.q, design.order, index + 1) * std::pow(design.q, 0.25);
+        const double denominator = iirDenominatorSum(design.q, design.order, index + 1) + 0.5;
+        const double ww = numerator / denominator;
+        const double wwSquared = ww * ww;
+        const double x = std::sqrt((1.0 - wwSquared * design.k) * (1.0 - wwSquared / design.k)) / (1.0 + wwSquared);
+
+        return (1.0 - x) / (1.0 + x);
+    }
+
+    int getNumStages(int factor) noexcept
+    {
+        int numStages = 0;
+
+        while ((1 << numStages) < factor)
+            ++numStages;
+
+        return numStages;
+    }
+
+    // Each octave up halves the passband edge relative to its rate and widens the
+    // transition up to the image of the edge
+    double getStageTransition(int stage) noexcept
+    {
+        return 0.5 - passbandEdge / (1 << stage);
+    }
+
+    // The delay at DC of one stage up and down again, in samples at its lower rate.
+    // The FIR half-band of 4m + 3 taps delays by 2m + 1 samples at the higher rate in
+    // each direction. An all-pass section a + z^-1 over 1 + a z^-1 at the lower rate
+    // delays DC by (1 - a) / (1 + a); the two directions together run every section
+    // of both chains once.
+    double getStageGroupDelay(Oversampler::FilterType filterType, double transition, double attenuationDb)
+    {
+        if (filterType == Oversampler::linearPhase)
+            return 2.0 * getFirHalfLength(transition, attenuationDb) + 1.0;
+
+        const auto design = getIirDesign(transition, attenuationDb);
+        double delay = 0.0;
+
+        for (int index = 0; index < design.numCoefficients; ++index)
+        {
+            // Summed in float, as the filters run
+            const double a = static_cast<float>(getIirCoefficient(design, index));
+            delay += (1.0 - a) / (1.0 + a);
+        }
+
+        return delay;
+    }
+}
+
+//==============================================================================
+void Oversampler::Stage::design(FilterType newFilterType, double transition, double attenuationDb)
+{
+    filterType = newFilterType;
+    const double pi = juce::MathConstants<double>::pi;
+
+    if (filterType == linearPhase)
+    {
+        const int m = getFirHalfLength(transition, attenuationDb);
+        const int centre = 2 * m + 1;
+        const double beta = 0.1102 * (attenuationDb - 8.7);
+
+        // Only the even taps are kept; the odd ones are zero apart from the centre
+        std::vector<double> evenTaps(static_cast<size_t>(centre + 1));
+        double sum = 0.0;
+
+        for (int i = 0; i <= centre; ++i)
+        {
+            const double offset = static_cast<double>(2 * i - centre);
+            const double ratio = offset / centre;
+            const double window = besselI0(beta * std::sqrt(juce::jmax(0.0, 1.0 - ratio * ratio))) / besselI0(beta);
+            const double sinc = std::sin(0.5 * pi * offset) / (0.5 * pi * offset);
+
+            evenTaps[static_cast<size_t>(i)] = sinc * window;
+            sum += evenTaps[static_cast<size_t>(i)];
+        }
+
+        taps.resize(evenTaps.size());
+
+        for (size_t i = 0; i < evenTaps.size(); ++i)
+            taps[taps.size() - 1 - i] = static_cast<float>(evenTaps[i] / sum);
+
+        centreDelay = m;
+    }
+    else
+    {
+        const auto iirDesign = getIirDesign(transition, attenuationDb);
+
+        for (auto& chain : chainCoefficients)
+            chain.clear();
+
+        for (int index = 0; index < iirDesign.numCoefficients; ++index)
+            chainCoefficients[static_cast<size_t>(index % 2)].push_back(static_cast<float>(getIirCoefficient(iirDesign, index)));
+
+        for (auto* state : { &upState, &downState })
+        {
+            for (size_t chain = 0; chain < 2; ++chain)
+            {
+                state->lastInputs[chain].assign(chainCoefficients[chain].size(), 0.0f);
+                state->lastOutputs[chain].assign(chainCoefficients[chain].size(), 0.0f);
+            }
+        }
+    }
+}
+
+void Oversampler::Stage::prepare(int maxNumInputSamples)
+{
+    if (filterType == linearPhase)
+    {
+        const auto numTaps = taps.size();
+        const auto numSamples = static_cast<size_t>(maxNumInputSamples);
+
+        upWork.allocate(numTaps - 1 + numSamples, true);
+        downWorkEven.allocate(numTaps - 1 + numSamples, true);
+        downWorkOdd.allocate(static_cast<size_t>(centreDelay + 1) + numSamples, true);
+        branchSum.allocate(numSamples, true);
+    }
+
+    reset();
+}
+
+void Oversampler::Stage::reset() noexcept
+{
+    if (filterType == linearPhase)
+    {
+        const size_t history = taps.size() - 1;
+
+        std::memset(upWork.get(), 0, sizeof(float) * history);
+        std::memset(downWorkEven.get(), 0, sizeof(float) * history);
+        std::memset(downWorkOdd.get(), 0, sizeof(float) * static_cast<size_t>(centreDelay + 1));
+    }
+    else
+    {
+        for (auto* state : { &upState, &downState })
+        {
+            for (size_t chain = 0; chain < 2; ++chain)
+            {
+                std::fill(state->lastInputs[chain].begin(), state->lastInputs[chain].end(), 0.0f);
+                std::fill(state->lastOutputs[chain].begin(), state->lastOutputs[chain].end(), 0.0f);
+            }
+        }
+    }
+}
+
+bool Oversampler::Stage::hasDecayed(float threshold) const noexcept
+{
+    auto below = [threshold] (const float* values, size_t numValues)
+    {
+        for (size_t i = 0; i < numValues; ++i)
+            if (std::abs(values[i]) > threshold)
+                return false;
+
+        return true;
+    };
+
+    if (filterType == linearPhase)
+        return below(upWork.get(), taps.size() - 1)
+            && below(downWorkEven.get(), taps.size() - 1)
+            && below(downWorkOdd.get(), static_cast<size_t>(centreDelay + 1));
+
+    for (const auto* state : { &upState, &downState })
+        for (size_t chain = 0; chain < 2; ++chain)
+            if (! below(state->lastInputs[chain].data(), state->lastInputs[chain].size())
+                || ! below(state->lastOutputs[chain].data(), state->lastOutputs[chain].size()))
+                return false;
+
+    return true;
+}
+
+void Oversampler::Stage::upsample(const float* input, float* output, int numSamples) noexcept
+{
+    if (filterType == linearPhase)
+        upsampleFir(input, output, numSamples);
+    else
+        upsampleIir(input, output, numSamples);
+}
+
+void Oversampler::Stage::downsample(const float* input, float* output, int numSamples) noexcept
+{
+    if (filterType == linearPhase)
+        downsampleFir(input, output, numSamples);
+    else
+        downsampleIir(input, output, numSamples);
+}
+
+void Oversampler::Stage::upsampleFir(const float* input, float* output, int numSamples) noexcept
+{
+    const int numTaps = static_cast<int>(taps.size());
+    const int history = numTaps - 1;
+    float* work = upWork.get();
+    float* sum = branchSum.get();
+
+    std::memcpy(work + history, input, sizeof(float) * static_cast<size_t>(numSamples));
+    std::fill(sum, sum + numSamples, 0.0f);
+
+    // One tap at a time over the whole chunk, so the inner loop vectorises
+    for (int k = 0; k < numTaps; ++k)
+    {
+        const float tap = taps[static_cast<size_t>(k)];
+        const float* x = work + k;
+
+        for (int n = 0; n < numSamples; ++n)
+            sum[n] += tap * x[n];
+    }
+
+    // The odd outputs come from the centre tap alone: the input, delayed
+    const float* centre = work + history - centreDelay;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        output[2 * n] = sum[n];
+        output[2 * n + 1] = centre[n];
+    }
+
+    std::memmove(work, work + numSamples, sizeof(float) * static_cast<size_t>(history));
+}
+
+void Oversampler::Stage::downsampleFir(const float* input, float* output, int numSamples) noexcept
+{
+    const int numTaps = static_cast<int>(taps.size());
+    const int history = numTaps - 1;
+    const int oddHistory = centreDelay + 1;
+    float* even = downWorkEven.get();
+    float* odd = downWorkOdd.get();
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        even[history + n] = input[2 * n];
+        odd[oddHistory + n] = input[2 * n + 1];
+    }
+
+    std::memcpy(output, odd, sizeof(float) * static_cast<size_t>(numSamples));
+
+    for (int k = 0; k < numTaps; ++k)
+    {
+        const float tap = taps[static_cast<size_t>(k)];
+        const float* x = even + k;
+
+        for (int n = 0; n < numSamples; ++n)
+            output[n] += tap * x[n];
+    }
+
+    // The taps were doubled for the upsampler's gain of two
+    for (int n = 0; n < numSamples; ++n)
+        output[n] *= 0.5f;
+
+    std::memmove(even, even + numSamples, sizeof(float) * static_cast<size_t>(history));
+    std::memmove(odd, odd + numSamples, sizeof(float) * static_cast<size_t>(oddHistory));
+}
+
+namespace
+{
+    // One chain of first-order all-passes in z^2, run at the lower rate
+    inline float runAllpassChain(float x, const float* coefficients, float* lastInputs, float* lastOutputs, size_t numSections) noexcept
+    {
+        for (size_t i = 0; i < numSections; ++i)
+        {
+            const float y = coefficients[i] * (x - lastOutputs[i]) + lastInputs[i];
+            lastInputs[i] = x;
+            lastOutputs[i] = y;
+            x = y;
+        }
+
+        return x;
+    }
+}
+
+void Oversampler::Stage::upsampleIir(const float* input, float* output, int numSamples) noexcept
+{
+    const size_t sections0 = chainCoefficients[0].size();
+    const size_t sections1 = chainCoefficients[1].size();
+    auto& state = upState;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        output[2 * n] = runAllpassChain(input[n], chainCoefficients[0].data(),
+                                        state.lastInputs[0].data(), state.lastOutputs[0].data(), sections0);
+        output[2 * n + 1] = runAllpassChain(input[n], chainCoefficients[1].data(),
+                                            state.lastInputs[1].data(), state.lastOutputs[1].data(), sections1);
+    }
+}
+
+void Oversampler::Stage::downsampleIir(const float* input, float* output, int numSamples) noexcept
+{
+    const size_t sections0 = chainCoefficients[0].size();
+    const size_t sections1 = chainCoefficients[1].size();
+
+    auto& state = downState;
+
+    // The first chain takes the odd samples, the second the even ones before them
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const float a = runAllpassChain(input[2 * n + 1], chainCoefficients[0].data(),
+                                        state.lastInputs[0].data(), state.lastOutputs[0].data(), sections0);
+        const float b = runAllpassChain(input[2 * n], chainCoefficients[1].data(),
+                                        state.lastInputs[1].data(), state.lastOutputs[1].data(), sections1);
+        output[n] = 0.5f * (a + b);
+    }
+}
+
+//==============================================================================
+void Oversampler::prepare(int newFactor, FilterType newFilterType, int maxNumSamples)
+{
+    factor = juce::jlimit(1, maxFactor, juce::nextPowerOfTwo(juce::jmax(1, newFactor)));
+    numStages = getNumStages(factor);
+
+    maxChunk = juce::jmax(1, maxNumSamples);
+    latency = 0;
+    oversampling = false;
+
+    if (! isEnabled())
+        return;
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        auto& stage = stages[static_cast<size_t>(s)];
+        stage.design(newFilterType, getStageTransition(s), stopbandAttenuationDb);
+        stage.prepare(maxChunk << s);
+    }
+
+    bufferA.allocate(static_cast<size_t>(maxChunk * factor), true);
+    bufferB.allocate(static_cast<size_t>(maxChunk * factor), true);
+    controlBuffer.allocate(static_cast<size_t>(maxChunk * factor), true);
+    primeInput.allocate(static_cast<size_t>(maxChunk), true);
+
+    const double groupDelay = getGroupDelay(factor, newFilterType);
+    latency = getLatencyFor(factor, newFilterType);
+
+    alignment.prepare(juce::roundToInt((latency - groupDelay) * factor), maxChunk * factor);
+    history.prepare(latency, maxChunk);
+
+    reset();
+}
+
+double Oversampler::getGroupDelay(int factor, FilterType filterType)
+{
+    // Each stage's round trip counts at its lower rate
+    double delay = 0.0;
+
+    for (int s = 0; s < getNumStages(factor); ++s)
+        delay += getStageGroupDelay(filterType, getStageTransition(s), stopbandAttenuationDb) / (1 << s);
+
+    return delay;
+}
+
+int Oversampler::getLatencyFor(int factor, FilterType filterType)
+{
+    factor = juce::jlimit(1, maxFactor, juce::nextPowerOfTwo(juce::jmax(1, factor)));
+
+    if (factor == 1)
+        return 0;
+
+    return static_cast<int>(std::ceil(getGroupDelay(factor, filterType) - 1.0e-3));
+}
+
+void Oversampler::reset() noexcept
+{
+    for (int s = 0; s < numStages; ++s)
+        stages[static_cast<size_t>(s)].reset();
+
+    alignment.reset();
+    history.reset();
+    oversampling = false;
+}
+
+float* Oversampler::upsample(const float* input, int numSamples) noexcept
+{
+    jassert(isEnabled() && numSamples <= maxChunk);
+
+    if (! oversampling)
+    {
+        prime();
+        oversampling = true;
+    }
+
+    history.push(input, numSamples);
+    return runUp(input, numSamples);
+}
+
+void Oversampler::downsample(float* output, int numSamples) noexcept
+{
+    alignment.process(topRate, numSamples * factor);
+    runDown(output, numSamples);
+}
+
+const float* Oversampler::holdControl(const float* values, int numSamples) noexcept
+{
+    float* held = controlBuffer.get();
+
+    for (int n = 0; n < numSamples; ++n)
+        for (int k = 0; k < factor; ++k)
+            held[n * factor + k] = values[n];
+
+    return held;
+}
+
+void Oversampler::delay(float* samples, int numSamples) noexcept
+{
+    if (! isEnabled())
+        return;
+
+    history.process(samples, numSamples);
+    oversampling = false;
+}
+
+bool Oversampler::hasDecayed(float threshold) const noexcept
+{
+    for (int s = 0; s < numStages; ++s)
+        if (! stages[static_cast<size_t>(s)].hasDecayed(threshold))
+            return false;
+
+    return alignment.hasDecayed(threshold) && history.hasDecayed(threshold);
+}
+
+void Oversampler::prime() noexcept
+{
+    // The filters run on the last chunk of input they missed, so that they pick up
+    // where delay() leaves off; the IIR's memory has faded well before that
+    for (int s = 0; s < numStages; ++s)
+        stages[static_cast<size_t>(s)].reset();
+
+    alignment.reset();
+
+    history.read(primeInput.get(), maxChunk, maxChunk);
+    runUp(primeInput.get(), maxChunk);
+    alignment.process(topRate, maxChunk * factor);
+    runDown(primeInput.get(), maxChunk);
+}
+
+float* Oversampler::runUp(const float* input, int numSamples) noexcept
+{
+    const float* source = input;
+    float* dest = nullptr;
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        dest = (s % 2 == 0) ? bufferA.get() : bufferB.get();
+        stages[static_cast<size_t>(s)].upsample(source, dest, numSamples << s);
+        source = dest;
+    }
+
+    topRate = dest;
+    return topRate;
+}
+
+void Oversampler::runDown(float* output, int numSamples) noexcept
+{
+    const float* source = topRate;
+
+    for (int s = numStages - 1; s >= 0; --s)
+    {
+        float* dest = (s == 0) ? output : (source == bufferA.get() ? bufferB.get() : bufferA.get());
+        stages[static_cast<size_t>(s)].downsample(source, dest, numSamples << s);
+        source = dest;
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "SampleDelay.h"
+
+#include <array>
+#include <vector>
+
+/*
+    2x, 4x or 8x oversampling of one signal around a nonlinear stage.
+
+    Each octave is a half-band stage: half the taps of a half-band filter are zero,
+    so in polyphase form one branch runs at the lower rate and the other is a plain
+    delay or a second, equally cheap branch. Upsampling runs the branches on the low
+    rate signal and interleaves them; downsampling splits the high rate signal into
+    its even and odd samples and adds the branches, so no product is ever taken of a
+    zero or of a sample that is thrown away. Later stages only have to keep the
+    images of the earlier ones out of the passband and need far fewer taps.
+
+    - linearPhase: Kaiser-windowed FIR half-bands. No phase distortion; the latency
+      is 65 to 74 samples, almost all of it from the first stage.
+    - lowLatency: polyphase IIR half-bands, two chains of first-order all-passes
+      each (the design of Laurent de Soras' HIIR). 4 or 5 samples of latency at
+      low frequencies, with the phase shift of an elliptic filter towards the top
+      of the band.
+
+    The passband reaches 0.45 of the sample rate and images are down at least 90 dB.
+    The latency is rounded up to whole samples at the native rate: the remainder is
+    made up by a delay at the top rate, exactly for the FIR and at DC for the IIR.
+
+    While the nonlinear stage is off, delay() passes the signal through delayed by
+    the same latency, so the two can alternate without a jump in time. The filters
+    are primed from the last input they missed when oversampling starts again.
+*/
+class Oversampler
+{
+public:
+    enum FilterType
+    {
+        lowLatency,
+        linearPhase
+    };
+
+    static constexpr int maxFactor = 8;
+
+    Oversampler() = default;
+
+    /** Designs the filters and allocates for chunks of up to maxNumSamples at the
+        native rate. A factor of 1 turns oversampling off. Not real-time safe. */
+    void prepare(int newFactor, FilterType newFilterType, int maxNumSamples);
+
+    void reset() noexcept;
+
+    bool isEnabled() const noexcept  { return factor > 1; }
+    int getFactor() const noexcept   { return factor; }
+
+    /** Samples at the native rate between a signal going in and coming out, both
+        through the oversampled stage and through delay(). */
+    int getLatency() const noexcept  { return latency; }
+
+    /** The latency prepare() gives for these settings, worked out from the filter
+        designs alone; nothing is allocated, so it suits the message thread. */
+    static int getLatencyFor(int factor, FilterType filterType);
+
+    /** Upsamples a chunk and returns the factor * numSamples samples at the top rate,
+        for the nonlinear stage to work on in place before downsample(). */
+    float* upsample(const float* input, int numSamples) noexcept;
+
+    /** Brings the samples that upsample() returned back to the native rate. */
+    void downsample(float* output, int numSamples) noexcept;
+
+    /** Repeats each of numSamples values factor times, for an amount that moves
+        along the chunk; valid until the next call. */
+    const float* holdControl(const float* values, int numSamples) noexcept;
+
+    /** Delays a block in place by the latency, for blocks where the nonlinear stage
+        is off; any length. */
+    void delay(float* samples, int numSamples) noexcept;
+
+    /** True if nothing above the threshold is left in the filters or delays. */
+    bool hasDecayed(float threshold) const noexcept;
+
+private:
+    // One octave: a half-band filter for each direction
+    class Stage
+    {
+    public:
+        void design(FilterType newFilterType, double transition, double attenuationDb);
+        void prepare(int maxNumInputSamples);
+        void reset() noexcept;
+
+        // numSamples is the length at the lower rate in both directions
+        void upsample(const float* input, float* output, int numSamples) noexcept;
+        void downsample(const float* input, float* output, int numSamples) noexcept;
+
+        bool hasDecayed(float threshold) const noexcept;
+
+    private:
+        void upsampleFir(const float* input, float* output, int numSamples) noexcept;
+        void downsampleFir(const float* input, float* output, int numSamples) noexcept;
+        void upsampleIir(const float* input, float* output, int numSamples) noexcept;
+        void downsampleIir(const float* input, float* output, int numSamples) noexcept;
+
+        FilterType filterType = linearPhase;
+
+        // FIR: the even taps of the half-band in reverse order, doubled, so that they
+        // sum to one; the odd taps are all zero but the centre one, which is 0.5.
+        // Each work buffer is the history of a branch followed by the new samples.
+        std::vector<float> taps;
+        int centreDelay = 0;
+        juce::HeapBlock<float> upWork, downWorkEven, downWorkOdd, branchSum;
+
+        // IIR: all-pass coefficients, the even ones for the first chain and the odd
+        // ones for the second, and for each direction the last input and output of
+        // every section
+        struct AllpassState
+        {
+            std::array<std::vector<float>, 2> lastInputs, lastOutputs;
+        };
+
+        std::array<std::vector<float>, 2> chainCoefficients;
+        AllpassState upState, downState;
+    };
+
+    // The round trip's delay at DC in samples at the native rate, fractional
+    static double getGroupDelay(int factor, FilterType filterType);
+
+    // Runs the filters alone, through the buffers between the stages
+    float* runUp(const float* input, int numSamples) noexcept;
+    void runDown(float* output, int numSamples) noexcept;
+
+    // Fills the filters from the history before oversampling starts again
+    void prime() noexcept;
+
+    int factor = 1;
+    int numStages = 0;
+    int latency = 0;
+    int maxChunk = 0;
+    std::array<Stage, 3> stages;
+
+    // Ping-pong buffers at the rates between the stages
+    juce::HeapBlock<float> bufferA, bufferB;
+    float* topRate = nullptr;
+    juce::HeapBlock<float> controlBuffer;
+
+    // Makes the round trip a whole number of native samples
+    SampleDelay<float> alignment;
+
+    // The native input, for delay() and for priming
+    SampleDelay<float> history;
+    juce::HeapBlock<float> primeInput;
+    bool oversampling = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Oversampler)
+};
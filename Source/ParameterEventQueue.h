@@ -0,0 +1,108 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/** A parameter change: the parameter's index in the processor's parameter list, its
+    new plain (not normalised) value, and where in the next block it takes effect. */
+struct ParameterEvent
+{
+    int parameterIndex = 0;
+    float value = 0.0f;
+    int sampleOffset = 0;
+};
+
+/*
+    Lock-free queue of parameter changes from listeners to the audio thread.
+
+    Changes come from several threads at once, the audio thread among them: host
+    automation reaches the listeners from the wrapper's processing callback, the
+    editor and preset loads from the message thread. So no producer may block
+    another. A producer claims a slot by advancing the write position with a
+    compare-and-swap, fills it and then publishes it through the slot's sequence
+    number; the consumer takes slots in order while their sequence says they are
+    full, and hands them back for the next lap the same way (D. Vyukov's bounded
+    queue, with a single consumer). Neither side ever waits: a producer whose
+    claimed slot is not yet published only holds back the changes behind it until
+    the next block. When the queue is full a change is dropped and the overflow
+    flag tells the consumer to re-read every parameter.
+*/
+class ParameterEventQueue
+{
+public:
+    static constexpr int capacity = 1024;
+
+    ParameterEventQueue() noexcept
+    {
+        for (size_t i = 0; i < slots.size(); ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const ParameterEvent& event) noexcept
+    {
+        auto position = writePosition.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& slot = slots[position & mask];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+            if (lag == 0)
+            {
+                // The slot is free on this lap; claim it unless another producer did first
+                if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.event = event;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lag < 0)
+            {
+                // Still holds a change from the lap before: the queue is full
+                overflowed.store(true);
+                return false;
+            }
+            else
+            {
+                position = writePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Only one thread may pop at a time, normally the audio thread. */
+    bool pop(ParameterEvent& event) noexcept
+    {
+        auto& slot = slots[readPosition & mask];
+
+        if (slot.sequence.load(std::memory_order_acquire) != readPosition + 1)
+            return false;
+
+        event = slot.event;
+        slot.sequence.store(readPosition + capacity, std::memory_order_release);
+        ++readPosition;
+        return true;
+    }
+
+    /** True once after any change was dropped. */
+    bool checkAndClearOverflow() noexcept  { return overflowed.exchange(false); }
+
+private:
+    static_assert((capacity & (capacity - 1)) == 0, "the capacity must be a power of two");
+    static constexpr size_t mask = capacity - 1;
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence { 0 };
+        ParameterEvent event;
+    };
+
+    std::array<Slot, capacity> slots;
+    std::atomic<size_t> writePosition { 0 };
+    size_t readPosition = 0;
+    std::atomic<bool> overflowed { false };
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Linear parameter smoothing that works a block at a time.
+
+    Same behaviour as a linear juce::SmoothedValue, but instead of stepping through
+    getNextValue() inside the per-sample loops, fillNextBlock() writes the values
+    for a whole block in one pass. Every value is computed from the start of the
+    ramp rather than by repeated addition, so the loop has no carried dependency and
+    vectorises, and the values do not depend on how the ramp is split into blocks.
+    A parameter that is not moving returns a constant Block without touching the
+    buffer, and callers take their fast path for it.
+*/
+class ParameterRamp
+{
+public:
+    /** The values of one block: per-sample values while ramping, otherwise just a constant. */
+    struct Block
+    {
+        const float* values = nullptr;   // null when the value is constant over the block
+        float value = 0.0f;              // the constant, or the value at the end of the ramp
+
+        bool isConstant() const noexcept              { return values == nullptr; }
+        float operator[](int i) const noexcept        { return values != nullptr ? values[i] : value; }
+
+        /** The part of the block starting at sample offset. */
+        Block from(int offset) const noexcept         { return { values != nullptr ? values + offset : nullptr, value }; }
+    };
+
+    void reset(double sampleRate, double rampLengthSeconds) noexcept
+    {
+        rampLength = juce::jmax(0, juce::roundToInt(sampleRate * rampLengthSeconds));
+        setCurrentAndTargetValue(target);
+    }
+
+    void setCurrentAndTargetValue(float newValue) noexcept
+    {
+        current = target = rampStart = newValue;
+        step = 0.0f;
+        countdown = 0;
+        rampPosition = 0;
+    }
+
+    void setTargetValue(float newValue) noexcept
+    {
+        if (newValue == target)
+            return;
+
+        if (rampLength <= 0)
+        {
+            setCurrentAndTargetValue(newValue);
+            return;
+        }
+
+        target = newValue;
+        rampStart = current;
+        rampPosition = 0;
+        countdown = rampLength;
+        step = (target - current) / static_cast<float>(countdown);
+    }
+
+    float getCurrentValue() const noexcept  { return current; }
+    float getTargetValue() const noexcept   { return target; }
+    bool isSmoothing() const noexcept       { return countdown > 0; }
+
+    /** Advances by numSamples. While ramping, the values go into buffer, which must
+        hold numSamples floats. */
+    Block fillNextBlock(float* buffer, int numSamples) noexcept
+    {
+        if (countdown <= 0)
+            return { nullptr, target };
+
+        const int rampSamples = juce::jmin(numSamples, countdown);
+        const float start = rampStart;
+        const float increment = step;
+        const int position = rampPosition + 1;
+
+        for (int n = 0; n < rampSamples; ++n)
+            buffer[n] = start + increment * static_cast<float>(position + n);
+
+        countdown -= rampSamples;
+        rampPosition += rampSamples;
+
+        if (countdown > 0)
+        {
+            current = buffer[rampSamples - 1];
+        }
+        else
+        {
+            current = target;
+            std::fill(buffer + rampSamples - 1, buffer + numSamples, target);
+        }
+
+        return { buffer, current };
+    }
+
+private:
+    float current = 0.0f;
+    float target = 0.0f;
+    float rampStart = 0.0f;
+    float step = 0.0f;
+    int countdown = 0;
+    int rampPosition = 0;
+    int rampLength = 0;
+};
@@ -1,5 +1,14 @@
 #include "PluginEditor.h"
 
+namespace
+{
+    constexpr int meterFrameRate = 30;
+    constexpr float meterFloorDb = -60.0f;
+
+    // Held peaks fall back by 20 dB per second
+    const float peakDecayPerFrame = juce::Decibels::decibelsToGain(-20.0f / meterFrameRate);
+}
+
 LazirkoAudioProcessorEditor::LazirkoAudioProcessorEditor(LazirkoAudioProcessor& p)
     : AudioProcessorEditor(&p), processor(p)
 {
@@ -33,6 +42,34 @@ LazirkoAudioProcessorEditor::LazirkoAudioProcessorEditor(LazirkoAudioProcessor&
     autoGainButton.setClickingTogglesState(true);
     addAndMakeVisible(autoGainButton);
 
+    bypassButton.setButtonText("BYPASS");
+    bypassButton.setClickingTogglesState(true);
+    addAndMakeVisible(bypassButton);
+
+    // Not a parameter: a trace runs while the button is on and is written to
+    // Documents/Lazirko Traces, one file per run
+    traceButton.setButtonText("TRACE");
+    traceButton.setClickingTogglesState(true);
+    traceButton.setToggleState(processor.getTracer().isRecording(), juce::dontSendNotification);
+    traceButton.onClick = [this]
+    {
+        auto& tracer = processor.getTracer();
+
+        if (! traceButton.getToggleState())
+        {
+            tracer.stop();
+            return;
+        }
+
+        const auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                              .getChildFile("Lazirko Traces")
+                              .getChildFile("trace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json");
+
+        if (! tracer.start(file))
+            traceButton.setToggleState(false, juce::dontSendNotification);
+    };
+    addAndMakeVisible(traceButton);
+
     auto& apvts = processor.getAPVTS();
 
     dephaseAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
@@ -43,11 +80,14 @@ LazirkoAudioProcessorEditor::LazirkoAudioProcessorEditor(LazirkoAudioProcessor&
         apvts, "MIX", mixSlider);
     autoGainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
         apvts, "AUTOGAIN", autoGainButton);
+    bypassAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        apvts, "BYPASS", bypassButton);
 
     modeSelector.addItem("Mono", 1);
     modeSelector.addItem("L/R", 2);
     modeSelector.addItem("M/S", 3);
     modeSelector.addItem("Transient/Sustain", 4);
+    modeSelector.addItem("Multiband", 5);
     modeSelector.setSelectedId(1);
     addAndMakeVisible(modeSelector);
 
@@ -58,10 +98,130 @@ LazirkoAudioProcessorEditor::LazirkoAudioProcessorEditor(LazirkoAudioProcessor&
     modeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
         apvts, "MODE", modeSelector);
 
-    setSize(420, 260);
+    bandsSlider.setSliderStyle(juce::Slider::IncDecButtons);
+    bandsSlider.setTextBoxStyle(juce::Slider::TextBoxLeft, false, 40, 20);
+    addAndMakeVisible(bandsSlider);
+
+    bandsLabel.setText("Bands", juce::dontSendNotification);
+    bandsLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(bandsLabel);
+
+    bandsAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        apvts, "BANDS", bandsSlider);
+
+    // Changing either makes the host re-prepare the plugin for the new latency
+    oversamplingSelector.addItem("Off", 1);
+    oversamplingSelector.addItem("2x", 2);
+    oversamplingSelector.addItem("4x", 3);
+    oversamplingSelector.addItem("8x", 4);
+    oversamplingSelector.setSelectedId(1);
+    addAndMakeVisible(oversamplingSelector);
+
+    oversamplingFilterSelector.addItem("Low Latency", 1);
+    oversamplingFilterSelector.addItem("Linear Phase", 2);
+    oversamplingFilterSelector.setSelectedId(1);
+    addAndMakeVisible(oversamplingFilterSelector);
+
+    oversamplingLabel.setText("Oversampling", juce::dontSendNotification);
+    oversamplingLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(oversamplingLabel);
+
+    oversamplingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        apvts, "OVERSAMPLING", oversamplingSelector);
+    oversamplingFilterAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        apvts, "OVERSAMPLING_FILTER", oversamplingFilterSelector);
+
+    // Auto switches to Render's kernels, not its oversampling, when the host bounces offline
+    qualitySelector.addItem("Auto", 1);
+    qualitySelector.addItem("Realtime", 2);
+    qualitySelector.addItem("Render", 3);
+    qualitySelector.setSelectedId(1);
+    addAndMakeVisible(qualitySelector);
+
+    qualityLabel.setText("Quality", juce::dontSendNotification);
+    qualityLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(qualityLabel);
+
+    qualityAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        apvts, "QUALITY", qualitySelector);
+
+    // Records from before the editor opened would show stale levels
+    TelemetryRecord stale;
+    while (processor.getTelemetry().pop(stale)) {}
+
+    processor.getTelemetry().setEnabled(true);
+
+    processor.getProfiler().reset();
+    processor.getProfiler().setEnabled(true);
+
+    startTimerHz(meterFrameRate);
+
+    setSize(420, 436);
+}
+
+LazirkoAudioProcessorEditor::~LazirkoAudioProcessorEditor()
+{
+    stopTimer();
+    processor.getTelemetry().setEnabled(false);
+    processor.getProfiler().setEnabled(false);
+}
+
+void LazirkoAudioProcessorEditor::timerCallback()
+{
+    double inputSquares = 0.0, outputSquares = 0.0;
+    int numSamples = 0;
+    float newInputPeak = 0.0f, newOutputPeak = 0.0f;
+    TelemetryRecord record;
+
+    while (processor.getTelemetry().pop(record))
+    {
+        const auto length = static_cast<double>(record.numSamples);
+        inputSquares += static_cast<double>(record.inputRMS) * record.inputRMS * length;
+        outputSquares += static_cast<double>(record.outputRMS) * record.outputRMS * length;
+        numSamples += record.numSamples;
+
+        newInputPeak = juce::jmax(newInputPeak, record.inputPeak);
+        newOutputPeak = juce::jmax(newOutputPeak, record.outputPeak);
+
+        gainCompensation = record.gainCompensation;
+        dephasing = record.dephasing;
+        damping = record.damping;
+    }
+
+    // Without blocks, as when the transport stops, the meters fall back to the floor
+    inputRMS = numSamples > 0 ? static_cast<float>(std::sqrt(inputSquares / numSamples)) : 0.0f;
+    outputRMS = numSamples > 0 ? static_cast<float>(std::sqrt(outputSquares / numSamples)) : 0.0f;
+    inputPeak = juce::jmax(newInputPeak, inputPeak * peakDecayPerFrame);
+    outputPeak = juce::jmax(newOutputPeak, outputPeak * peakDecayPerFrame);
+
+    blockCost = processor.getProfiler().getReport(CpuProfiler::wholeBlock);
+
+    repaint(meterArea);
 }
 
-LazirkoAudioProcessorEditor::~LazirkoAudioProcessorEditor() = default;
+void LazirkoAudioProcessorEditor::drawMeter(juce::Graphics& g, juce::Rectangle<int> area, const juce::String& name,
+    float rms, float peak) const
+{
+    auto toProportion = [] (float gain)
+    {
+        return juce::jlimit(0.0f, 1.0f, 1.0f - juce::Decibels::gainToDecibels(gain, meterFloorDb) / meterFloorDb);
+    };
+
+    g.setColour(juce::Colours::white);
+    g.drawText(name, area.removeFromLeft(40), juce::Justification::centredLeft);
+
+    const auto bar = area.toFloat();
+    g.setColour(juce::Colours::black);
+    g.fillRect(bar);
+
+    g.setColour(juce::Colours::limegreen);
+    g.fillRect(bar.withWidth(bar.getWidth() * toProportion(rms)));
+
+    // A peak line, red once the signal clips
+    g.setColour(peak >= 1.0f ? juce::Colours::red : juce::Colours::white);
+    const float peakX = bar.getX() + bar.getWidth() * toProportion(peak);
+    g.drawVerticalLine(juce::roundToInt(peakX), bar.getY(), bar.getBottom());
+}
 
 void LazirkoAudioProcessorEditor::paint(juce::Graphics& g)
 {
@@ -70,6 +230,30 @@ void LazirkoAudioProcessorEditor::paint(juce::Graphics& g)
     g.setFont(juce::FontOptions(16.0f));
     g.drawFittedText("Quantum Noise Channel", getLocalBounds().removeFromTop(30),
                       juce::Justification::centred, 1);
+
+    auto area = meterArea;
+    g.setFont(juce::FontOptions(13.0f));
+    drawMeter(g, area.removeFromTop(16), "In", inputRMS, inputPeak);
+    area.removeFromTop(6);
+    drawMeter(g, area.removeFromTop(16), "Out", outputRMS, outputPeak);
+    area.removeFromTop(6);
+
+    const auto settings = juce::String("Gain ") + juce::String(juce::Decibels::gainToDecibels(gainCompensation), 1) + " dB"
+                        + "   Dephasing " + juce::String(dephasing, 2)
+                        + "   Damping " + juce::String(damping, 2);
+
+    g.setColour(juce::Colours::white);
+    g.drawText(settings, area.removeFromTop(18), juce::Justification::centredLeft);
+
+    // Blocks that took all of their budget were late; red once there has been one
+    const auto cpu = juce::String("CPU ") + juce::String(blockCost.p50Budget, 1) + "%"
+                   + "   p99 " + juce::String(blockCost.p99Budget, 1) + "%"
+                   + "   max " + juce::String(blockCost.maxBudget, 1) + "%"
+                   + "   late " + juce::String(static_cast<juce::int64>(blockCost.overDeadline))
+                   + " of " + juce::String(static_cast<juce::int64>(blockCost.count));
+
+    g.setColour(blockCost.overDeadline > 0 ? juce::Colours::red : juce::Colours::white);
+    g.drawText(cpu, area.removeFromTop(18), juce::Justification::centredLeft);
 }
 
 void LazirkoAudioProcessorEditor::resized()
@@ -97,11 +281,31 @@ void LazirkoAudioProcessorEditor::resized()
 
     r.removeFromTop(10);
     auto buttonArea = r.removeFromTop(30);
-    autoGainButton.setBounds(buttonArea.withSizeKeepingCentre(120, 28));
+    const int buttonWidth = buttonArea.getWidth() / 3;
+    autoGainButton.setBounds(buttonArea.removeFromLeft(buttonWidth).withSizeKeepingCentre(120, 28));
+    bypassButton.setBounds(buttonArea.removeFromLeft(buttonWidth).withSizeKeepingCentre(120, 28));
+    traceButton.setBounds(buttonArea.withSizeKeepingCentre(120, 28));
 
     r.removeFromTop(8);
     auto modeRow = r.removeFromTop(30);
     auto modeLabelArea = modeRow.removeFromLeft(60);
     modeLabel.setBounds(modeLabelArea);
+    auto bandsArea = modeRow.removeFromRight(140);
+    bandsLabel.setBounds(bandsArea.removeFromLeft(50));
+    bandsSlider.setBounds(bandsArea.reduced(0, 2));
     modeSelector.setBounds(modeRow.reduced(8, 2));
+
+    r.removeFromTop(8);
+    auto oversamplingRow = r.removeFromTop(30);
+    oversamplingLabel.setBounds(oversamplingRow.removeFromLeft(90));
+    oversamplingFilterSelector.setBounds(oversamplingRow.removeFromRight(140).reduced(0, 2));
+    oversamplingSelector.setBounds(oversamplingRow.reduced(8, 2));
+
+    r.removeFromTop(8);
+    auto qualityRow = r.removeFromTop(30);
+    qualityLabel.setBounds(qualityRow.removeFromLeft(90));
+    qualitySelector.setBounds(qualityRow.removeFromLeft(160).reduced(8, 2));
+
+    r.removeFromTop(12);
+    meterArea = r.removeFromTop(80);
 }
@@ -3,7 +3,8 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 
-class LazirkoAudioProcessorEditor : public juce::AudioProcessorEditor
+class LazirkoAudioProcessorEditor : public juce::AudioProcessorEditor,
+                                    private juce::Timer
 {
 public:
     explicit LazirkoAudioProcessorEditor(LazirkoAudioProcessor&);
@@ -13,6 +14,11 @@ public:
     void resized() override;
 
 private:
+    // Drains the telemetry queue, reads the profiler and repaints the meters
+    void timerCallback() override;
+
+    void drawMeter(juce::Graphics& g, juce::Rectangle<int> area, const juce::String& name, float rms, float peak) const;
+
     LazirkoAudioProcessor& processor;
 
     juce::Slider dephaseSlider;
@@ -24,14 +30,42 @@ private:
     juce::Label mixLabel;
 
     juce::ToggleButton autoGainButton;
+    juce::ToggleButton bypassButton;
+    juce::ToggleButton traceButton;
     juce::ComboBox modeSelector;
     juce::Label modeLabel;
+    juce::Slider bandsSlider;
+    juce::Label bandsLabel;
+    juce::ComboBox oversamplingSelector;
+    juce::ComboBox oversamplingFilterSelector;
+    juce::Label oversamplingLabel;
+    juce::ComboBox qualitySelector;
+    juce::Label qualityLabel;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> dephaseAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> dampingAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mixAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> autoGainAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> bypassAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> modeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bandsAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingFilterAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> qualityAttachment;
+
+    // Meter state, in linear gain: RMS over the last frame, peaks held and falling
+    // back at a fixed rate, and the settings of the last block
+    juce::Rectangle<int> meterArea;
+    float inputRMS = 0.0f;
+    float inputPeak = 0.0f;
+    float outputRMS = 0.0f;
+    float outputPeak = 0.0f;
+    float gainCompensation = 1.0f;
+    float dephasing = 0.0f;
+    float damping = 0.0f;
+
+    // processBlock's share of the real-time budget since the editor opened
+    CpuProfiler::StageReport blockCost;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LazirkoAudioProcessorEditor)
 };
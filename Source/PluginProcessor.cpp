@@ -1,9 +1,138 @@
 #include "PluginProcessor.h"
 
-#include "PluginEditor.h"
+#if ! LAZIRKO_HEADLESS
+ #include "PluginEditor.h"
+#endif
+
+#include "AllocationGuard.h"
 
+#include <cstdint>
 #include <cstring>
 
+// Posts every change of one parameter to the audio thread's queue
+class LazirkoAudioProcessor::ParameterForwarder : public juce::AudioProcessorValueTreeState::Listener
+{
+public:
+    ParameterForwarder(LazirkoAudioProcessor& ownerProcessor, int index)
+        : owner(ownerProcessor), parameterIndex(index) {}
+
+    void parameterChanged(const juce::String&, float newValue) override
+    {
+        owner.parameterEvents.push({ parameterIndex, newValue, 0 });
+    }
+
+private:
+    LazirkoAudioProcessor& owner;
+    const int parameterIndex;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterForwarder)
+};
+
+// Reports the latency of new OVERSAMPLING or QUALITY settings from the message
+// thread, which makes the host prepare the processor again with them
+class LazirkoAudioProcessor::LatencyUpdater : public juce::AudioProcessorValueTreeState::Listener,
+                                              private juce::AsyncUpdater
+{
+public:
+    explicit LatencyUpdater(LazirkoAudioProcessor& ownerProcessor) : owner(ownerProcessor) {}
+    ~LatencyUpdater() override { cancelPendingUpdate(); }
+
+    void parameterChanged(const juce::String&, float) override
+    {
+        triggerAsyncUpdate();
+    }
+
+private:
+    void handleAsyncUpdate() override
+    {
+        owner.setLatencySamples(owner.getLatencyForSettings());
+    }
+
+    LazirkoAudioProcessor& owner;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyUpdater)
+};
+
+// The band workers of every instance, started with the first instance that needs
+// them and stopped when the last one lets go
+struct LazirkoAudioProcessor::SharedBandWorkers
+{
+    RealtimeWorkerPool pool { juce::jmin(3, juce::SystemStats::getNumCpus() - 1) };
+};
+
+// Takes the band workers from the message thread when MODE or PARALLEL_BANDS turn
+// them on during playback, so the audio thread never starts threads
+class LazirkoAudioProcessor::BandWorkersUpdater : public juce::AudioProcessorValueTreeState::Listener,
+                                                  private juce::AsyncUpdater
+{
+public:
+    explicit BandWorkersUpdater(LazirkoAudioProcessor& ownerProcessor) : owner(ownerProcessor) {}
+    ~BandWorkersUpdater() override { cancelPendingUpdate(); }
+
+    void parameterChanged(const juce::String&, float) override
+    {
+        triggerAsyncUpdate();
+    }
+
+private:
+    void handleAsyncUpdate() override
+    {
+        owner.acquireBandWorkersIfNeeded();
+    }
+
+    LazirkoAudioProcessor& owner;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BandWorkersUpdater)
+};
+
+namespace
+{
+    // A choice that changes the latency, so hosts should not automate it
+    class SettingParameter : public juce::AudioParameterChoice
+    {
+    public:
+        using juce::AudioParameterChoice::AudioParameterChoice;
+        bool isAutomatable() const override { return false; }
+    };
+
+    // OVERSAMPLING is Off, 2x, 4x or 8x; OVERSAMPLING_FILTER the index of a FilterType
+    int getOversamplingFactor(float choice) noexcept
+    {
+        return 1 << juce::jlimit(0, 3, juce::roundToInt(choice));
+    }
+
+    Oversampler::FilterType getOversamplingFilter(float choice) noexcept
+    {
+        return choice > 0.5f ? Oversampler::linearPhase : Oversampler::lowLatency;
+    }
+
+    // QUALITY is Auto, Realtime or Render; Auto renders at render quality whenever
+    // the host processes offline
+    bool usesRenderQuality(float choice, bool nonRealtime) noexcept
+    {
+        const int quality = juce::roundToInt(choice);
+        return quality == 2 || (quality == 0 && nonRealtime);
+    }
+
+    // Only an explicit Render changes the oversampling. Under Auto the latency has to
+    // stay what it was in playback: hosts take latency changes asynchronously, so one
+    // made while preparing for a bounce could offset the bounce
+    bool usesRenderOversampling(float choice) noexcept
+    {
+        return juce::roundToInt(choice) == 2;
+    }
+
+    // At Render quality damping is oversampled at least this much, with the
+    // linear-phase filters
+    constexpr int renderOversamplingFactor = 4;
+
+    void applyRenderQuality(int& factor, Oversampler::FilterType& filterType) noexcept
+    {
+        factor = juce::jmax(factor, renderOversamplingFactor);
+        filterType = Oversampler::linearPhase;
+    }
+}
+
 LazirkoAudioProcessor::LazirkoAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
     : AudioProcessor(BusesProperties()
@@ -19,14 +148,99 @@ LazirkoAudioProcessor::LazirkoAudioProcessor()
     : parameters(*this, nullptr, "PARAMETERS", createParameterLayout())
 #endif
 {
-    dephasingParam = parameters.getRawParameterValue("DEPHASE");
-    dampingParam = parameters.getRawParameterValue("DAMPING");
-    mixParam = parameters.getRawParameterValue("MIX");
-    autoGainParam = parameters.getRawParameterValue("AUTOGAIN");
-    modeParam = parameters.getRawParameterValue("MODE");
+    for (auto* parameter : getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+        {
+            parameterIDs.add(ranged->paramID);
+            parameterSources.push_back(parameters.getRawParameterValue(ranged->paramID));
+        }
+    }
+
+    parameterValues.resize(parameterSources.size());
+    syncParameterValues();
+
+    for (int i = 0; i < parameterIDs.size(); ++i)
+    {
+        parameterForwarders.push_back(std::make_unique<ParameterForwarder>(*this, i));
+        parameters.addParameterListener(parameterIDs[i], parameterForwarders.back().get());
+    }
+
+    dephasingParam = getParameterValue("DEPHASE");
+    dampingParam = getParameterValue("DAMPING");
+    mixParam = getParameterValue("MIX");
+    autoGainParam = getParameterValue("AUTOGAIN");
+    modeParam = getParameterValue("MODE");
+    numBandsParam = getParameterValue("BANDS");
+    parallelBandsParam = getParameterValue("PARALLEL_BANDS");
+    bypassParam = getParameterValue("BYPASS");
+    oversamplingParam = getParameterValue("OVERSAMPLING");
+    oversamplingFilterParam = getParameterValue("OVERSAMPLING_FILTER");
+    qualityParam = getParameterValue("QUALITY");
+
+    for (int band = 0; band < maxBands; ++band)
+    {
+        const juce::String prefix = "BAND" + juce::String(band + 1);
+        bandDephasingParams[static_cast<size_t>(band)] = getParameterValue(prefix + "_DEPHASE");
+        bandDampingParams[static_cast<size_t>(band)] = getParameterValue(prefix + "_DAMPING");
+    }
+
+    latencyUpdater = std::make_unique<LatencyUpdater>(*this);
+    parameters.addParameterListener("OVERSAMPLING", latencyUpdater.get());
+    parameters.addParameterListener("OVERSAMPLING_FILTER", latencyUpdater.get());
+    parameters.addParameterListener("QUALITY", latencyUpdater.get());
+
+    bandWorkersUpdater = std::make_unique<BandWorkersUpdater>(*this);
+    parameters.addParameterListener("MODE", bandWorkersUpdater.get());
+    parameters.addParameterListener("PARALLEL_BANDS", bandWorkersUpdater.get());
+
+    quantumKernels = &QuantumKernels::selectBestKernels();
+
+    dephaseNoiseA.setStream(0);
+    dephaseNoiseB.setStream(1);
+
+    for (size_t i = 0; i < bandNoise.size(); ++i)
+        bandNoise[i].setStream(static_cast<juce::uint32>(2 + i));
+
+    setNoiseSeed(static_cast<juce::uint64>(juce::Random::getSystemRandom().nextInt64()));
+}
+
+LazirkoAudioProcessor::~LazirkoAudioProcessor()
+{
+    parameters.removeParameterListener("OVERSAMPLING", latencyUpdater.get());
+    parameters.removeParameterListener("OVERSAMPLING_FILTER", latencyUpdater.get());
+    parameters.removeParameterListener("QUALITY", latencyUpdater.get());
+    parameters.removeParameterListener("MODE", bandWorkersUpdater.get());
+    parameters.removeParameterListener("PARALLEL_BANDS", bandWorkersUpdater.get());
+
+    for (int i = 0; i < parameterIDs.size(); ++i)
+        parameters.removeParameterListener(parameterIDs[i], parameterForwarders[static_cast<size_t>(i)].get());
 }
 
-LazirkoAudioProcessor::~LazirkoAudioProcessor() {}
+const float* LazirkoAudioProcessor::getParameterValue(const juce::String& parameterID) const
+{
+    const int index = parameterIDs.indexOf(parameterID);
+    jassert(index >= 0);
+    return &parameterValues[static_cast<size_t>(index)];
+}
+
+void LazirkoAudioProcessor::syncParameterValues()
+{
+    ParameterEvent event;
+    while (parameterEvents.pop(event)) {}
+
+    for (size_t i = 0; i < parameterSources.size(); ++i)
+        parameterValues[i] = parameterSources[i]->load();
+}
+
+bool LazirkoAudioProcessor::queueParameterChange(const juce::String& parameterID, float value, int sampleOffset)
+{
+    const int index = parameterIDs.indexOf(parameterID);
+    if (index < 0)
+        return false;
+
+    return parameterEvents.push({ index, value, juce::jmax(0, sampleOffset) });
+}
 
 const juce::String LazirkoAudioProcessor::getName() const { return JucePlugin_Name; }
 
@@ -57,7 +271,7 @@ bool LazirkoAudioProcessor::isMidiEffect() const
    #endif
 }
 
-double LazirkoAudioProcessor::getTailLengthSeconds() const { return 0.0; }
+double LazirkoAudioProcessor::getTailLengthSeconds() const { return tailLengthSeconds; }
 
 int LazirkoAudioProcessor::getNumPrograms() { return 1; }
 
@@ -87,54 +301,131 @@ juce::AudioProcessorValueTreeState::ParameterLayout LazirkoAudioProcessor::creat
 
     layout.add(std::make_unique<juce::AudioParameterChoice>(
         "MODE", "Mode",
-        juce::StringArray{ "Mono", "L/R", "M/S", "T/S" }, 0));
+        juce::StringArray{ "Mono", "L/R", "M/S", "T/S", "Multiband" }, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterInt>(
+        "BANDS", "Bands", minBands, maxBands, 4));
+
+    // Multiband only: each band scales the global dephasing and damping
+    for (int band = 1; band <= maxBands; ++band)
+    {
+        const juce::String prefix = "BAND" + juce::String(band);
+        const juce::String name = "Band " + juce::String(band);
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            prefix + "_DEPHASE", name + " Dephasing",
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 1.0f));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            prefix + "_DAMPING", name + " Damping",
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 1.0f));
+    }
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        "PARALLEL_BANDS", "Parallel Bands", false));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        "BYPASS", "Bypass", false));
+
+    // Oversampling of the damping stage; the IIR filters add a few samples of
+    // latency, the linear-phase FIRs 65 to 74
+    layout.add(std::make_unique<SettingParameter>(
+        "OVERSAMPLING", "Oversampling",
+        juce::StringArray{ "Off", "2x", "4x", "8x" }, 0));
+
+    layout.add(std::make_unique<SettingParameter>(
+        "OVERSAMPLING_FILTER", "Oversampling Filter",
+        juce::StringArray{ "Low Latency", "Linear Phase" }, 0));
+
+    // Processing tier: Realtime runs the SIMD kernels and the oversampling chosen
+    // above; Render adds oversampling and the precise kernels. Auto uses the precise
+    // kernels in bounces but keeps the oversampling, and so the latency
+    layout.add(std::make_unique<SettingParameter>(
+        "QUALITY", "Quality",
+        juce::StringArray{ "Auto", "Realtime", "Render" }, 0));
 
     return layout;
 }
 
 void LazirkoAudioProcessor::setupFilters(double sampleRate, float cutoffFreq)
 {
-    float omega = 2.0f * juce::MathConstants<float>::pi * cutoffFreq / static_cast<float>(sampleRate);
-    float alpha = std::sin(omega) / (2.0f * 0.707f);
-    float cosw = std::cos(omega);
-    float a0 = 1.0f + alpha;
-
-    // High-pass
-    transientFilterHP_L.setCoefficients(
-        (1.0f + cosw) / (2.0f * a0),
-        -(1.0f + cosw) / a0,
-        (1.0f + cosw) / (2.0f * a0),
-        (-2.0f * cosw) / a0,
-        (1.0f - alpha) / a0
-    );
-    transientFilterHP_R.setCoefficients(
-        (1.0f + cosw) / (2.0f * a0),
-        -(1.0f + cosw) / a0,
-        (1.0f + cosw) / (2.0f * a0),
-        (-2.0f * cosw) / a0,
-        (1.0f - alpha) / a0
-    );
+    const double omega = 2.0 * juce::MathConstants<double>::pi * cutoffFreq / sampleRate;
+    const double alpha = std::sin(omega) / (2.0 * 0.707);
+    const double cosw = std::cos(omega);
+    const double a0 = 1.0 + alpha;
 
     // Low-pass
-    transientFilterLP_L.setCoefficients(
-        (1.0f - cosw) / (2.0f * a0),
-        (1.0f - cosw) / a0,
-        (1.0f - cosw) / (2.0f * a0),
-        (-2.0f * cosw) / a0,
-        (1.0f - alpha) / a0
-    );
-    transientFilterLP_R.setCoefficients(
-        (1.0f - cosw) / (2.0f * a0),
-        (1.0f - cosw) / a0,
-        (1.0f - cosw) / (2.0f * a0),
-        (-2.0f * cosw) / a0,
-        (1.0f - alpha) / a0
-    );
-
-    transientFilterHP_L.reset();
-    transientFilterHP_R.reset();
-    transientFilterLP_L.reset();
-    transientFilterLP_R.reset();
+    for (int channel = 0; channel < 2; ++channel)
+        transientFilterLP.setCoefficients(channel,
+            (1.0 - cosw) / (2.0 * a0),
+            (1.0 - cosw) / a0,
+            (1.0 - cosw) / (2.0 * a0),
+            (-2.0 * cosw) / a0,
+            (1.0 - alpha) / a0
+        );
+
+    transientFilterLP.reset();
+}
+
+void LazirkoAudioProcessor::setupCrossovers(double sampleRate, int newNumBands)
+{
+    numBands = juce::jlimit(minBands, maxBands, newNumBands);
+
+    std::array<std::array<double, 5>, maxBands - 1> allpass {};
+
+    for (int c = 0; c < numBands - 1; ++c)
+    {
+        // Crossovers spread evenly on a log scale between 40 Hz and 16 kHz
+        const double frequency = juce::jmin(40.0 * std::pow(400.0, static_cast<double>(c + 1) / numBands),
+                                            sampleRate * 0.45);
+        const double omega = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
+        const double alpha = std::sin(omega) / juce::MathConstants<double>::sqrt2;   // Butterworth, Q = 1/sqrt(2)
+        const double cosw = std::cos(omega);
+        const double a0 = 1.0 + alpha;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            for (auto* section : { &crossoverSection1[static_cast<size_t>(c)], &crossoverSection2[static_cast<size_t>(c)] })
+            {
+                // Low-pass
+                section->setCoefficients(channel * 2,
+                    (1.0 - cosw) / (2.0 * a0),
+                    (1.0 - cosw) / a0,
+                    (1.0 - cosw) / (2.0 * a0),
+                    (-2.0 * cosw) / a0,
+                    (1.0 - alpha) / a0);
+
+                // High-pass
+                section->setCoefficients(channel * 2 + 1,
+                    (1.0 + cosw) / (2.0 * a0),
+                    -(1.0 + cosw) / a0,
+                    (1.0 + cosw) / (2.0 * a0),
+                    (-2.0 * cosw) / a0,
+                    (1.0 - alpha) / a0);
+            }
+        }
+
+        // LR4 low plus high pass is this second-order all-pass
+        allpass[static_cast<size_t>(c)] = { (1.0 - alpha) / a0, (-2.0 * cosw) / a0, 1.0,
+                                            (-2.0 * cosw) / a0, (1.0 - alpha) / a0 };
+    }
+
+    // Round r gives band k the all-pass of crossover k + 1 + r
+    for (int round = 0; round < numBands - 2; ++round)
+    {
+        for (int band = 0; band < numBands - 2 - round; ++band)
+        {
+            const auto& ap = allpass[static_cast<size_t>(band + 1 + round)];
+
+            for (int channel = 0; channel < 2; ++channel)
+                crossoverAllpass[static_cast<size_t>(round)].setCoefficients(band * 2 + channel,
+                    ap[0], ap[1], ap[2], ap[3], ap[4]);
+        }
+    }
+
+    for (auto& bank : crossoverSection1)  bank.reset();
+    for (auto& bank : crossoverSection2)  bank.reset();
+    for (auto& bank : crossoverAllpass)   bank.reset();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -160,7 +451,9 @@ bool LazirkoAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) c
 
 void LazirkoAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    ensureQuantumStateSize(samplesPerBlock);
+    allocateScratch(samplesPerBlock);
+    syncParameterValues();
+    profiler.setSampleRate(sampleRate);
 
     // Fast smoothing for immediate response
     const double rampLengthSeconds = 0.005;
@@ -170,103 +463,384 @@ void LazirkoAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock
     smoothedGainCompensation.reset(sampleRate, 0.05);
     smoothedGainCompensation.setCurrentAndTargetValue(1.0f);
 
+    // The bypass crossfade keeps its own copy of the dry input, at most one fade long
+    const int fadeSamples = juce::jmax(1, juce::roundToInt(sampleRate * bypassFadeSeconds));
+    bypassFade.reset(sampleRate, bypassFadeSeconds);
+    bypassFade.setCurrentAndTargetValue(*bypassParam > 0.5f ? 1.0f : 0.0f);
+    bypassFadeGains.allocate(static_cast<size_t>(fadeSamples), true);
+    bypassDryFloat.setSize(2, fadeSamples);
+    bypassDryDouble.setSize(2, fadeSamples);
+    bypassFadeLength = fadeSamples;
+
     setupFilters(sampleRate, 800.0f);
+    setupCrossovers(sampleRate, static_cast<int>(*numBandsParam));
 
-    inputRMS = 0.0f;
-    outputRMS = 0.0f;
+    // The audio thread is stopped, so the workers can also be let go here
+    if (needsBandWorkers())
+        acquireBandWorkersIfNeeded();
+    else
+        releaseBandWorkers();
+
+    // The tier is fixed until the next prepareToPlay, which hosts call after
+    // switching between playback and offline rendering
+    renderQuality = usesRenderQuality(*qualityParam, isNonRealtime());
+    quantumKernels = renderQuality ? &QuantumKernels::getPreciseKernels() : &QuantumKernels::selectBestKernels();
+    setupOversampling();
+
+    loudness.prepare(sampleRate);
+    followingLoudness = false;
+    tailDecayed = true;
 }
 
-void LazirkoAudioProcessor::releaseResources() {}
+void LazirkoAudioProcessor::releaseResources()
+{
+    releaseBandWorkers();
+}
 
-void LazirkoAudioProcessor::ensureQuantumStateSize(int numSamples)
+bool LazirkoAudioProcessor::needsBandWorkers() const
 {
-    if (numSamples != lastBlockSize)
-    {
-        size_t size = static_cast<size_t>(numSamples);
-        quantumStateA.resize(size);
-        quantumStateB.resize(size);
-        dryBufferA.resize(size);
-        dryBufferB.resize(size);
-        wetBufferA.resize(size);
-        wetBufferB.resize(size);
-        lastBlockSize = numSamples;
-    }
+    // MODE is Mono, L/R, M/S, T/S or Multiband
+    return juce::roundToInt(parameters.getRawParameterValue("MODE")->load()) == Multiband - 1
+        && parameters.getRawParameterValue("PARALLEL_BANDS")->load() > 0.5f
+        && juce::SystemStats::getNumCpus() > 1;
 }
 
-float LazirkoAudioProcessor::calculateRMS(const float* data, int numSamples)
+void LazirkoAudioProcessor::acquireBandWorkersIfNeeded()
 {
-    if (numSamples <= 0)
-        return 0.0f;
+    const juce::ScopedLock lock(bandWorkersLock);
+
+    if (sharedBandWorkers != nullptr || ! needsBandWorkers())
+        return;
+
+    sharedBandWorkers = std::make_unique<juce::SharedResourcePointer<SharedBandWorkers>>();
+    bandWorkers.store(&sharedBandWorkers->get().pool, std::memory_order_release);
+}
 
-    double sumSquares = 0.0;
-    for (int n = 0; n < numSamples; ++n)
+void LazirkoAudioProcessor::releaseBandWorkers()
+{
+    const juce::ScopedLock lock(bandWorkersLock);
+
+    bandWorkers.store(nullptr, std::memory_order_release);
+    sharedBandWorkers.reset();
+}
+
+void LazirkoAudioProcessor::setupOversampling()
+{
+    int factor = getOversamplingFactor(*oversamplingParam);
+    auto filterType = getOversamplingFilter(*oversamplingFilterParam);
+
+    if (usesRenderOversampling(*qualityParam))
+        applyRenderQuality(factor, filterType);
+
+    // The channel sees one chunk at a time
+    for (auto& oversampler : oversamplers)
+        oversampler.prepare(factor, filterType, quantumChunkSize);
+
+    oversamplingLatency = oversamplers[0].getLatency();
+
+    for (auto& delay : inputDelayFloat)   delay.prepare(oversamplingLatency, maxBlockSize);
+    for (auto& delay : inputDelayDouble)  delay.prepare(oversamplingLatency, maxBlockSize);
+    for (auto& delay : filteredDryDelay)  delay.prepare(oversamplingLatency, maxBlockSize);
+
+    delaysClear = true;
+    setLatencySamples(oversamplingLatency);
+}
+
+int LazirkoAudioProcessor::getLatencyForSettings() const
+{
+    int factor = getOversamplingFactor(parameters.getRawParameterValue("OVERSAMPLING")->load());
+    auto filterType = getOversamplingFilter(parameters.getRawParameterValue("OVERSAMPLING_FILTER")->load());
+
+    if (usesRenderOversampling(parameters.getRawParameterValue("QUALITY")->load()))
+        applyRenderQuality(factor, filterType);
+
+    return Oversampler::getLatencyFor(factor, filterType);
+}
+
+void LazirkoAudioProcessor::clearDelays() noexcept
+{
+    // The input delays are left alone: they always hold the latest input
+    for (auto& oversampler : oversamplers)
+        oversampler.reset();
+
+    for (auto& delay : filteredDryDelay)
+        delay.reset();
+
+    delaysClear = true;
+}
+
+template <typename SampleType>
+void LazirkoAudioProcessor::readDelayedInput(juce::AudioBuffer<SampleType>& dest, int destStart, int blockStart,
+    int numSamples) noexcept
+{
+    auto& inputDelays = getInputDelays<SampleType>();
+    const int age = inputDelayBlockLength - blockStart + oversamplingLatency;
+
+    for (int channel = 0; channel < juce::jmin(2, dest.getNumChannels()); ++channel)
+        inputDelays[static_cast<size_t>(channel)].read(dest.getWritePointer(channel) + destStart, age, numSamples);
+}
+
+void LazirkoAudioProcessor::allocateScratch(int blockSize)
+{
+    blockSize = juce::jmax(1, blockSize);
+    if (blockSize == maxBlockSize)
+        return;
+
+    // Every buffer starts on a 64-byte boundary
+    constexpr size_t floatsPerLine = 64 / sizeof(float);
+    auto roundUp = [] (int n) { return (static_cast<size_t>(n) + floatsPerLine - 1) & ~(floatsPerLine - 1); };
+
+    const size_t chunkFloats = roundUp(quantumChunkSize);
+    const size_t blockFloats = roundUp(blockSize);
+    const size_t totalFloats = (5 + 4 * maxBands) * chunkFloats + (8 + 2 * maxBands) * blockFloats;
+
+    scratchArena.allocate(totalFloats + floatsPerLine, true);
+
+    auto address = reinterpret_cast<std::uintptr_t>(scratchArena.get());
+    float* next = scratchArena.get() + ((64 - (address & 63)) & 63) / sizeof(float);
+
+    auto take = [&next] (size_t numFloats)
+    {
+        float* span = next;
+        next += numFloats;
+        return span;
+    };
+
+    quantumStateA.re = take(chunkFloats);
+    quantumStateA.im = take(chunkFloats);
+    quantumStateB.re = take(chunkFloats);
+    quantumStateB.im = take(chunkFloats);
+    dephaseNoise = take(chunkFloats);
+    wetBufferA = take(blockFloats);
+    wetBufferB = take(blockFloats);
+    filteredDryL = take(blockFloats);
+    filteredDryR = take(blockFloats);
+    dephaseRampBuffer = take(blockFloats);
+    dampRampBuffer = take(blockFloats);
+    gainRampBuffer = take(blockFloats);
+    mixRampBuffer = take(blockFloats);
+
+    for (size_t band = 0; band < maxBands; ++band)
     {
-        const double val = static_cast<double>(data[n]);
-        sumSquares += val * val;
+        bandImaginary[band] = take(chunkFloats);
+        bandNoiseBuffers[band] = take(chunkFloats);
+        bandDephaseRamps[band] = take(chunkFloats);
+        bandDampRamps[band] = take(chunkFloats);
     }
-    return static_cast<float>(std::sqrt(sumSquares / static_cast<double>(numSamples)));
+
+    bandSignals = take(2 * maxBands * blockFloats);
+    bandStride = blockFloats;
+
+    maxBlockSize = blockSize;
 }
 
-void LazirkoAudioProcessor::applyQuantumChannel(std::vector<Complex>& state,
-    float dephase, float damp, int numSamples)
+void LazirkoAudioProcessor::setNoiseSeed(juce::uint64 seed)
 {
-    const double pDephase = juce::jlimit(0.0, 1.0, static_cast<double>(dephase));
-    const double pDamp = juce::jlimit(0.0, 1.0, static_cast<double>(damp));
+    dephaseNoiseA.setSeed(seed);
+    dephaseNoiseB.setSeed(seed);
 
-    if (pDephase < 1e-6 && pDamp < 1e-6)
-        return;
+    for (auto& noise : bandNoise)
+        noise.setSeed(seed);
+}
+
+template <bool Dephase, bool Damp>
+void LazirkoAudioProcessor::applyQuantumChannel(QuantumState& state, QuantumNoise& noise, float* noiseBuffer,
+    Oversampler& oversampler, const ParameterRamp::Block& dephase, const ParameterRamp::Block& damp,
+    int startSample, int numSamples)
+{
+    const CpuProfiler::ScopedTimer timer(profiler, CpuProfiler::quantumChannel, numSamples);
+
+    // Encoding put the signal in the real part; the imaginary part starts at zero
+    std::memset(state.im, 0, sizeof(float) * static_cast<size_t>(numSamples));
 
     // DEPHASING: Aggressive phase scrambling
-    if (pDephase > 1e-6)
+    if constexpr (Dephase)
     {
-        const double maxPhaseShift = juce::MathConstants<double>::pi * pDephase;
-        for (int n = 0; n < numSamples; ++n)
+        const TraceRecorder::ScopedEvent event(*tracer, "dephase");
+
+        noise.seek(noisePosition + static_cast<juce::uint64>(startSample));
+        noise.fill(noiseBuffer, numSamples);
+
+        if (dephase.isConstant())
+            quantumKernels->dephase(state.re, state.im, noiseBuffer, numSamples, dephase.value);
+        else
+            quantumKernels->dephaseRamp(state.re, state.im, noiseBuffer, numSamples, dephase.values);
+    }
+
+    // DAMPING: Strong saturation with makeup gain. Oversampled, only the real part
+    // goes through it, as nothing reads the imaginary part after this.
+    if constexpr (Damp)
+    {
+        const TraceRecorder::ScopedEvent event(*tracer, "damp");
+
+        if (oversampler.isEnabled())
         {
-            Complex& amp = state[static_cast<size_t>(n)];
-            const double mag = std::abs(amp);
-            if (mag > 1e-12)
-            {
-                double phase = std::atan2(amp.imag(), amp.real());
+            float* upsampled = oversampler.upsample(state.re, numSamples);
+            const int numUpsampled = numSamples * oversampler.getFactor();
 
-                // Random phase shift
-                const double randPhase = (randomGen.nextFloat() * 2.0 - 1.0) * maxPhaseShift;
-                phase += randPhase;
+            if (damp.isConstant())
+                quantumKernels->dampReal(upsampled, numUpsampled, damp.value);
+            else
+                quantumKernels->dampRealRamp(upsampled, numUpsampled, oversampler.holdControl(damp.values, numSamples));
 
-                // Mix toward magnitude-only for coherence loss
-                const double coherence = 1.0 - pDephase * 0.5;
-                const Complex rotated(mag * std::cos(phase), mag * std::sin(phase));
-                const Complex magnitudeOnly(mag, 0.0);
-                amp = coherence * rotated + (1.0 - coherence) * magnitudeOnly;
-            }
+            oversampler.downsample(state.re, numSamples);
+        }
+        else if (damp.isConstant())
+        {
+            quantumKernels->damp(state.re, state.im, numSamples, damp.value);
+        }
+        else
+        {
+            quantumKernels->dampRamp(state.re, state.im, numSamples, damp.values);
         }
     }
+    else
+    {
+        oversampler.delay(state.re, numSamples);
+    }
+}
 
-    // DAMPING: Strong saturation with makeup gain
-    if (pDamp > 1e-6)
+//==============================================================================
+namespace
+{
+    // x - x is zero for finite x and NaN for NaN/Inf, so this compiles to a
+    // compare and a blend instead of a branch
+    inline float zeroIfNotFinite(float x) noexcept
     {
-        const double drive = 1.0 + 7.0 * pDamp;
-        const double makeup = 1.0 + 1.5 * pDamp;
+        return (x - x == 0.0f) ? x : 0.0f;
+    }
 
-        for (int n = 0; n < numSamples; ++n)
+    // Stands in for a per-sample array when a parameter holds still
+    struct ConstantRamp
+    {
+        float value;
+        float operator[](int) const noexcept { return value; }
+    };
+
+    // Early exit on the first loud chunk; within a chunk the loop vectorises (an int
+    // flag does, a bool or a running max does not)
+    template <typename SampleType>
+    bool isSilent(const SampleType* data, int numSamples, SampleType threshold) noexcept
+    {
+        constexpr int chunkSize = 64;
+
+        for (int start = 0; start < numSamples; start += chunkSize)
         {
-            Complex& amp = state[static_cast<size_t>(n)];
-            double re = amp.real() * drive;
-            double im = amp.imag() * drive;
+            const int end = juce::jmin(numSamples, start + chunkSize);
+            int loud = 0;
+
+            for (int n = start; n < end; ++n)
+                loud |= static_cast<int>(std::abs(data[n]) > threshold);
+
+            if (loud != 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    // Host samples into the float buffers of the channel and filters
+    template <typename SampleType>
+    void copyToFloat(float* dest, const SampleType* source, int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            std::memcpy(dest, source, sizeof(float) * static_cast<size_t>(numSamples));
+        else
+            for (int n = 0; n < numSamples; ++n)
+                dest[n] = static_cast<float>(source[n]);
+    }
+
+    // RMS over all samples of the first numChannels channels, and their peak
+    template <typename SampleType>
+    void measureLevels(const juce::AudioBuffer<SampleType>& buffer, int numChannels, float& rms, float& peak) noexcept
+    {
+        const int numSamples = buffer.getNumSamples();
+        double sumOfMeanSquares = 0.0;
+        rms = peak = 0.0f;
 
-            // Soft saturation
-            re = re / (1.0 + std::abs(re));
-            im = im / (1.0 + std::abs(im));
+        if (numChannels <= 0 || numSamples <= 0)
+            return;
 
-            amp = Complex(re * makeup, im * makeup);
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto channelRMS = static_cast<double>(buffer.getRMSLevel(channel, 0, numSamples));
+            sumOfMeanSquares += channelRMS * channelRMS;
+            peak = juce::jmax(peak, static_cast<float>(buffer.getMagnitude(channel, 0, numSamples)));
         }
+
+        rms = static_cast<float>(std::sqrt(sumOfMeanSquares / numChannels));
     }
 }
 
 void LazirkoAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    juce::ScopedNoDenormals noDenormals;
     juce::ignoreUnused(midiMessages);
+    processSamples(buffer, false);
+}
+
+void LazirkoAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer, false);
+}
+
+// Hosts that bypass without the BYPASS parameter call these instead; they get the
+// same crossfade
+void LazirkoAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer, true);
+}
+
+void LazirkoAudioProcessor::processBlockBypassed(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer, true);
+}
+
+juce::AudioProcessorParameter* LazirkoAudioProcessor::getBypassParameter() const
+{
+    return parameters.getParameter("BYPASS");
+}
+
+template <typename SampleType>
+void LazirkoAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, bool bypassedByHost)
+{
+    juce::ScopedNoDenormals noDenormals;
+    const AllocationGuard::ScopedNoAllocation noAllocation;
+    const CpuProfiler::ScopedTimer timer(profiler, CpuProfiler::wholeBlock, buffer.getNumSamples());
+    const TraceRecorder::ScopedEvent event(*tracer, "processBlock");
+
+    if (! telemetry.isEnabled())
+    {
+        processHostBlock(buffer, bypassedByHost);
+        return;
+    }
+
+    const int numIns = juce::jmin(getTotalNumInputChannels(), buffer.getNumChannels());
+    const int numOuts = juce::jmin(getTotalNumOutputChannels(), buffer.getNumChannels());
+
+    TelemetryRecord record;
+    record.numSamples = buffer.getNumSamples();
+    measureLevels(buffer, numIns, record.inputRMS, record.inputPeak);
 
+    processHostBlock(buffer, bypassedByHost);
+
+    measureLevels(buffer, numOuts, record.outputRMS, record.outputPeak);
+
+    // The settings the signal actually went through: mid-ramp values, and none
+    // of them once bypassed
+    const float processed = 1.0f - bypassFade.getCurrentValue();
+    record.gainCompensation = smoothedGainCompensation.getCurrentValue();
+    record.dephasing = smoothedDephasing.getCurrentValue() * processed;
+    record.damping = smoothedDamping.getCurrentValue() * processed;
+
+    telemetry.push(record);
+}
+
+template <typename SampleType>
+void LazirkoAudioProcessor::processHostBlock(juce::AudioBuffer<SampleType>& buffer, bool bypassedByHost)
+{
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -274,386 +848,923 @@ void LazirkoAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce:
         buffer.clear(i, 0, buffer.getNumSamples());
 
     const int numSamples = buffer.getNumSamples();
-    if (numSamples <= 0)
+    if (numSamples <= 0 || buffer.getNumChannels() <= 0)
         return;
 
-    ensureQuantumStateSize(numSamples);
+    // prepareToPlay must have allocated the scratch arena
+    jassert(maxBlockSize > 0);
+    if (maxBlockSize <= 0)
+        return;
 
-    // Immediate parameter update
-    smoothedDephasing.setCurrentAndTargetValue(dephasingParam->load());
-    smoothedDamping.setCurrentAndTargetValue(dampingParam->load());
-    smoothedMix.setTargetValue(mixParam->load());
+    // The input delays hold one announced block beyond the latency, so larger host
+    // blocks run as several. The first piece takes all parameter changes; those
+    // beyond it take effect at the start of the next piece.
+    if (oversamplingLatency > 0 && numSamples > maxBlockSize)
+    {
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+        {
+            juce::AudioBuffer<SampleType> piece(buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                                start, juce::jmin(maxBlockSize, numSamples - start));
+            processHostBlock(piece, bypassedByHost);
+        }
+
+        return;
+    }
 
-    int mode = static_cast<int>(modeParam->load()) + 1;
+    const int numChannels = juce::jmin(2, buffer.getNumChannels());
 
-    switch (mode)
+    if (oversamplingLatency > 0)
     {
-    case 2: // LeftRight
-        processLeftRightMode(buffer, numSamples);
-        break;
-    case 3: // MidSide
-        processMidSideMode(buffer, numSamples);
-        break;
-    case 4: // TransientSustain
-        processTransientSustainMode(buffer, numSamples);
-        break;
-    case 1: // Mono
-    default:
-        processMonoMode(buffer, numSamples);
-        break;
+        auto& inputDelays = getInputDelays<SampleType>();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            inputDelays[static_cast<size_t>(channel)].push(buffer.getReadPointer(channel), numSamples);
+
+        inputDelayBlockLength = numSamples;
     }
-}
 
-void LazirkoAudioProcessor::processMonoMode(juce::AudioBuffer<float>& buffer, int numSamples)
-{
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    if (parameterEvents.checkAndClearOverflow())
+        syncParameterValues();
+
+    // Take this block's parameter changes in order of their offsets; changes with
+    // the same offset keep the order they were made in
+    int numEvents = 0;
+    while (numEvents < static_cast<int>(pendingEvents.size()) && parameterEvents.pop(pendingEvents[static_cast<size_t>(numEvents)]))
+        ++numEvents;
 
-    // Sum to mono
-    if (totalNumInputChannels == 1)
+    for (int i = 1; i < numEvents; ++i)
     {
-        std::memcpy(dryBufferA.data(), buffer.getReadPointer(0),
-            sizeof(float) * static_cast<size_t>(numSamples));
+        const auto event = pendingEvents[static_cast<size_t>(i)];
+        int j = i;
+
+        for (; j > 0 && pendingEvents[static_cast<size_t>(j - 1)].sampleOffset > event.sampleOffset; --j)
+            pendingEvents[static_cast<size_t>(j)] = pendingEvents[static_cast<size_t>(j - 1)];
+
+        pendingEvents[static_cast<size_t>(j)] = event;
     }
-    else if (totalNumInputChannels >= 2)
+
+    auto applyAllEvents = [this, numEvents]
     {
-        const float* leftIn = buffer.getReadPointer(0);
-        const float* rightIn = buffer.getReadPointer(1);
-        for (int n = 0; n < numSamples; ++n)
-            dryBufferA[static_cast<size_t>(n)] = leftIn[n] + rightIn[n];
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const auto& event = pendingEvents[static_cast<size_t>(i)];
+            parameterValues[static_cast<size_t>(event.parameterIndex)] = event.value;
+        }
+    };
+
+    // Bypass follows the last BYPASS change of the block and fades from its start
+    bool bypassed = bypassedByHost || *bypassParam > 0.5f;
+    const int bypassIndex = static_cast<int>(bypassParam - parameterValues.data());
+
+    for (int i = 0; i < numEvents; ++i)
+        if (pendingEvents[static_cast<size_t>(i)].parameterIndex == bypassIndex)
+            bypassed = bypassedByHost || pendingEvents[static_cast<size_t>(i)].value > 0.5f;
+
+    bypassFade.setTargetValue(bypassed ? 1.0f : 0.0f);
+
+    // Fully bypassed: the input is the output, delayed like the processed signal.
+    // What the oversamplers held is stale by the time processing resumes.
+    if (! bypassFade.isSmoothing() && bypassed)
+    {
+        applyAllEvents();
+        skipBlock(numSamples);
+
+        if (oversamplingLatency > 0)
+        {
+            readDelayedInput(buffer, 0, 0, numSamples);
+
+            if (! delaysClear)
+                clearDelays();
+        }
+
+        return;
     }
 
-    inputRMS = calculateRMS(dryBufferA.data(), numSamples);
+    const int numIns = juce::jlimit(1, 2, juce::jmin(totalNumInputChannels, buffer.getNumChannels()));
+    bool inputSilent = true;
 
-    // Encode
-    for (int n = 0; n < numSamples; ++n)
-        quantumStateA[static_cast<size_t>(n)] = Complex(dryBufferA[static_cast<size_t>(n)], 0.0);
+    for (int channel = 0; channel < numIns && inputSilent; ++channel)
+        inputSilent = isSilent(buffer.getReadPointer(channel), numSamples, static_cast<SampleType>(silenceThreshold));
+
+    // With silent input and the filter tails gone, the output would be silent too,
+    // so the input passes through and only the parameters move on
+    if (inputSilent && tailDecayed)
+    {
+        applyAllEvents();
+        bypassFade.setCurrentAndTargetValue(bypassed ? 1.0f : 0.0f);
+        skipBlock(numSamples);
 
-    // Process
-    float dephase = smoothedDephasing.getCurrentValue();
-    float damp = smoothedDamping.getCurrentValue();
-    applyQuantumChannel(quantumStateA, dephase, damp, numSamples);
+        if (oversamplingLatency > 0)
+            readDelayedInput(buffer, 0, 0, numSamples);
 
-    // Decode
-    for (int n = 0; n < numSamples; ++n)
-        wetBufferA[static_cast<size_t>(n)] = static_cast<float>(quantumStateA[static_cast<size_t>(n)].real());
+        return;
+    }
 
-    outputRMS = calculateRMS(wetBufferA.data(), numSamples);
+    // During a bypass fade the start of the block is processed as usual and then
+    // blended with a copy of its input. Fading into bypass, nothing after the fade
+    // needs processing.
+    const int fadeLength = bypassFade.isSmoothing() ? juce::jmin(numSamples, bypassFadeLength) : 0;
+    const int numToProcess = (fadeLength > 0 && bypassed) ? fadeLength : numSamples;
+    auto& bypassDry = getBypassDryBuffer<SampleType>();
 
-    // Auto-gain
-    bool autoGainEnabled = (autoGainParam->load() > 0.5f);
-    if (autoGainEnabled && outputRMS > 1e-6f && inputRMS > 1e-6f)
-        smoothedGainCompensation.setTargetValue(juce::jlimit(0.1f, 10.0f, inputRMS / outputRMS));
+    if (fadeLength > 0 && oversamplingLatency > 0)
+        readDelayedInput(bypassDry, 0, 0, fadeLength);
     else
-        smoothedGainCompensation.setTargetValue(1.0f);
+        for (int channel = 0; channel < numChannels && fadeLength > 0; ++channel)
+            bypassDry.copyFrom(channel, 0, buffer, channel, 0, fadeLength);
+
+    if (oversamplingLatency > 0 && numToProcess < numSamples)
+        readDelayedInput(buffer, numToProcess, numToProcess, numSamples - numToProcess);
+
+    // Split the block where parameters change; a block without changes is one segment
+    int nextEvent = 0;
+    int segmentStart = 0;
+
+    while (segmentStart < numToProcess)
+    {
+        for (; nextEvent < numEvents && pendingEvents[static_cast<size_t>(nextEvent)].sampleOffset <= segmentStart; ++nextEvent)
+        {
+            const auto& event = pendingEvents[static_cast<size_t>(nextEvent)];
+            parameterValues[static_cast<size_t>(event.parameterIndex)] = event.value;
+        }
+
+        const int segmentEnd = nextEvent < numEvents ? juce::jmin(numToProcess, pendingEvents[static_cast<size_t>(nextEvent)].sampleOffset)
+                                                     : numToProcess;
+
+        processSegment(buffer, segmentStart, segmentEnd - segmentStart);
+        segmentStart = segmentEnd;
+    }
 
-    // Mix
-    for (int n = 0; n < numSamples; ++n)
+    // Changes past the processed part still count for the next block
+    for (; nextEvent < numEvents; ++nextEvent)
     {
-        float gainComp = smoothedGainCompensation.getNextValue();
-        float mixVal = smoothedMix.getNextValue();
+        const auto& event = pendingEvents[static_cast<size_t>(nextEvent)];
+        parameterValues[static_cast<size_t>(event.parameterIndex)] = event.value;
+    }
 
-        float dry = dryBufferA[static_cast<size_t>(n)];
-        float wet = wetBufferA[static_cast<size_t>(n)] * gainComp;
+    noisePosition += static_cast<juce::uint64>(numSamples - numToProcess);
 
-        if (std::isnan(wet) || std::isinf(wet))
-            wet = 0.0f;
+    if (fadeLength > 0)
+    {
+        const auto fade = bypassFade.fillNextBlock(bypassFadeGains, fadeLength);
 
-        float output = dry * (1.0f - mixVal) + wet * mixVal;
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            SampleType* output = buffer.getWritePointer(channel);
+            const SampleType* dry = bypassDry.getReadPointer(channel);
 
-    for (int ch = 0; ch < totalNumOutputChannels; ++ch)
-            buffer.setSample(ch, n, output);
+            for (int n = 0; n < fadeLength; ++n)
+                output[n] += (dry[n] - output[n]) * fade.values[n];
+        }
+    }
+
+    tailDecayed = inputSilent && settleFilters();
 }
+
+void LazirkoAudioProcessor::skipBlock(int numSamples)
+{
+    smoothedDephasing.setCurrentAndTargetValue(juce::jlimit(0.0f, 1.0f, *dephasingParam));
+    smoothedDamping.setCurrentAndTargetValue(juce::jlimit(0.0f, 1.0f, *dampingParam));
+    smoothedMix.setCurrentAndTargetValue(juce::jlimit(0.0f, 1.0f, *mixParam));
+
+    noisePosition += static_cast<juce::uint64>(numSamples);
+
+    // As after silence, the gain compensation starts again from unity, and the
+    // loudness window from the end of this block
+    smoothedGainCompensation.setCurrentAndTargetValue(1.0f);
+    loudness.reset(noisePosition);
 }
 
-void LazirkoAudioProcessor::processLeftRightMode(juce::AudioBuffer<float>& buffer, int numSamples)
+bool LazirkoAudioProcessor::settleFilters()
 {
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    const double threshold = silenceThreshold;
+
+    if (! transientFilterLP.hasDecayed(threshold))
+        return false;
+
+    for (auto& oversampler : oversamplers)
+        if (! oversampler.hasDecayed(silenceThreshold))
+            return false;
+
+    for (size_t channel = 0; channel < 2; ++channel)
+        if (! filteredDryDelay[channel].hasDecayed(silenceThreshold)
+            || ! inputDelayFloat[channel].hasDecayed(silenceThreshold)
+            || ! inputDelayDouble[channel].hasDecayed(threshold))
+            return false;
+
+    for (size_t c = 0; c < crossoverSection1.size(); ++c)
+        if (! crossoverSection1[c].hasDecayed(threshold) || ! crossoverSection2[c].hasDecayed(threshold))
+            return false;
+
+    for (auto& allpass : crossoverAllpass)
+        if (! allpass.hasDecayed(threshold))
+            return false;
+
+    // Flush what is left so that it cannot come back as denormals or a click
+    transientFilterLP.reset();
 
-    if (totalNumInputChannels >= 2)
+    for (size_t c = 0; c < crossoverSection1.size(); ++c)
     {
-        std::memcpy(dryBufferA.data(), buffer.getReadPointer(0),
-            sizeof(float) * static_cast<size_t>(numSamples));
-        std::memcpy(dryBufferB.data(), buffer.getReadPointer(1),
-            sizeof(float) * static_cast<size_t>(numSamples));
+        crossoverSection1[c].reset();
+        crossoverSection2[c].reset();
     }
-    else if (totalNumInputChannels == 1)
-{
-        std::memcpy(dryBufferA.data(), buffer.getReadPointer(0),
-            sizeof(float) * static_cast<size_t>(numSamples));
-        std::memcpy(dryBufferB.data(), buffer.getReadPointer(0),
-            sizeof(float) * static_cast<size_t>(numSamples));
+
+    for (auto& allpass : crossoverAllpass)
+        allpass.reset();
+
+    if (! delaysClear)
+        clearDelays();
+
+    return true;
 }
 
-    float leftInRMS = calculateRMS(dryBufferA.data(), numSamples);
-    float rightInRMS = calculateRMS(dryBufferB.data(), numSamples);
-    inputRMS = (leftInRMS + rightInRMS) * 0.5f;
+template <typename SampleType>
+void LazirkoAudioProcessor::processSegment(juce::AudioBuffer<SampleType>& buffer, int segmentStart, int numSamples)
+{
+    const int totalNumInputChannels = getTotalNumInputChannels();
+    const int totalNumOutputChannels = getTotalNumOutputChannels();
+
+    // Queued changes and rendered automation can be out of range; the kernels
+    // assume amounts in [0, 1]
+    smoothedDephasing.setTargetValue(juce::jlimit(0.0f, 1.0f, *dephasingParam));
+    smoothedDamping.setTargetValue(juce::jlimit(0.0f, 1.0f, *dampingParam));
+    smoothedMix.setTargetValue(juce::jlimit(0.0f, 1.0f, *mixParam));
+
+    const int mode = juce::jlimit(1, 5, static_cast<int>(*modeParam) + 1);
+    const int numIns = juce::jlimit(1, 2, juce::jmin(totalNumInputChannels, buffer.getNumChannels()));
+    const int numOuts = juce::jlimit(1, 2, juce::jmin(totalNumOutputChannels, buffer.getNumChannels()));
+
+    // A stage runs if it is on anywhere along its ramp
+    const bool dephaseActive = juce::jmax(smoothedDephasing.getCurrentValue(), smoothedDephasing.getTargetValue()) > 1e-6f;
+    const bool dampActive = juce::jmax(smoothedDamping.getCurrentValue(), smoothedDamping.getTargetValue()) > 1e-6f;
+    const bool autoGainEnabled = (*autoGainParam > 0.5f);
+
+    const int requestedBands = juce::jlimit(minBands, maxBands, static_cast<int>(*numBandsParam));
+    if (mode == Multiband && requestedBands != numBands)
+        setupCrossovers(getSampleRate(), requestedBands);
+
+    // Without dephasing and damping, L/R and M/S give back their input when the
+    // layout is the same on both sides; the other modes sum or filter even then.
+    // With oversampling the oversamplers have to follow the signal all the same.
+    const bool neutral = ! dephaseActive && ! dampActive && numIns == numOuts
+                      && (mode == LeftRight || mode == MidSide)
+                      && ! smoothedGainCompensation.isSmoothing() && smoothedGainCompensation.getCurrentValue() == 1.0f
+                      && oversamplingLatency == 0;
+
+    if (neutral)
+    {
+        skipBlock(numSamples);
+        return;
+    }
+
+    // The loudness window starts empty whenever auto-gain comes on
+    if (autoGainEnabled && ! followingLoudness)
+        loudness.reset(noisePosition);
+
+    followingLoudness = autoGainEnabled;
+
+    if (oversamplingLatency > 0)
+        delaysClear = false;
+
+    const size_t index = static_cast<size_t>(mode - 1) * 32
+                       + static_cast<size_t>(numIns - 1) * 16
+                       + static_cast<size_t>(numOuts - 1) * 8
+                       + (dephaseActive ? 4u : 0u)
+                       + (dampActive ? 2u : 0u)
+                       + (autoGainEnabled ? 1u : 0u);
+
+    // Segments larger than announced in prepareToPlay run as several sub-blocks
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+    {
+        const int count = juce::jmin(maxBlockSize, numSamples - start);
 
-    // Encode
-    for (int n = 0; n < numSamples; ++n)
+        {
+            const CpuProfiler::ScopedTimer timer(profiler, CpuProfiler::modeProcessor, count);
+            const TraceRecorder::ScopedEvent event(*tracer, "mode");
+            (this->*getModeProcessors<SampleType>()[index])(buffer, segmentStart + start, count);
+        }
+
+        noisePosition += static_cast<juce::uint64>(count);
+    }
+}
+
+//==============================================================================
+template <typename SampleType, size_t Index>
+constexpr LazirkoAudioProcessor::ModeProcessor<SampleType> LazirkoAudioProcessor::getModeProcessor()
 {
-        quantumStateA[static_cast<size_t>(n)] = Complex(dryBufferA[static_cast<size_t>(n)], 0.0);
-        quantumStateB[static_cast<size_t>(n)] = Complex(dryBufferB[static_cast<size_t>(n)], 0.0);
+    constexpr int mode = static_cast<int>(Index / 32) + 1;
+    constexpr int numIns = static_cast<int>((Index / 16) % 2) + 1;
+    constexpr int numOuts = static_cast<int>((Index / 8) % 2) + 1;
+    constexpr bool dephase = ((Index / 4) % 2) != 0;
+    constexpr bool damp = ((Index / 2) % 2) != 0;
+    constexpr bool autoGain = (Index % 2) != 0;
+
+    if constexpr (mode == Multiband)
+        return &LazirkoAudioProcessor::processMultiband<SampleType, numIns, numOuts, dephase, damp, autoGain>;
+    else
+        return &LazirkoAudioProcessor::processMode<SampleType, mode, numIns, numOuts, dephase, damp, autoGain>;
 }
 
-    // Process
-    float dephase = smoothedDephasing.getCurrentValue();
-    float damp = smoothedDamping.getCurrentValue();
-    applyQuantumChannel(quantumStateA, dephase, damp, numSamples);
-    applyQuantumChannel(quantumStateB, dephase, damp, numSamples);
+template <typename SampleType, size_t... Indices>
+constexpr std::array<LazirkoAudioProcessor::ModeProcessor<SampleType>, sizeof...(Indices)>
+    LazirkoAudioProcessor::makeModeProcessors(std::index_sequence<Indices...>)
+{
+    return { getModeProcessor<SampleType, Indices>()... };
+}
 
-    // Decode
-    for (int n = 0; n < numSamples; ++n)
+template <typename SampleType>
+auto LazirkoAudioProcessor::getModeProcessors() noexcept -> const std::array<ModeProcessor<SampleType>, numModeProcessors>&
 {
-        wetBufferA[static_cast<size_t>(n)] = static_cast<float>(quantumStateA[static_cast<size_t>(n)].real());
-        wetBufferB[static_cast<size_t>(n)] = static_cast<float>(quantumStateB[static_cast<size_t>(n)].real());
+    // Built at compile time, so there is no guard to check on the audio thread
+    static constexpr auto processors = makeModeProcessors<SampleType>(std::make_index_sequence<numModeProcessors>());
+    return processors;
 }
 
-    float leftOutRMS = calculateRMS(wetBufferA.data(), numSamples);
-    float rightOutRMS = calculateRMS(wetBufferB.data(), numSamples);
-    outputRMS = (leftOutRMS + rightOutRMS) * 0.5f;
+/*
+    Each mode runs in chunks of quantumChunkSize samples: encode, channel, decode,
+    loudness measurement and the dry/wet mix all happen on one chunk while it is
+    in cache. Auto-gain keeps a copy of the encoded chunk so that the loudness
+    window sees the signal both before and after the channel; the gain it asks for
+    ramps in from the next hop, so nothing waits for the end of the block. The dry
+    signal is always re-read from the host buffer, which is only overwritten by
+    the mix.
+
+    Parameter ramps are written for the whole sub-block up front, and only for
+    parameters that are moving; the chunks read their slice of them.
+
+    Mode, channel counts and the active stages are template parameters, so the
+    per-sample loops carry no branches and can be vectorised by the compiler.
+
+    The sample type is the host's. Double-precision hosts get their samples read
+    and written as doubles, and the dry path and mix stay in double; only the
+    signal entering the channel is rounded to the float state of the kernels.
+*/
+template <typename SampleType, int Mode, int NumIns, int NumOuts, bool Dephase, bool Damp, bool AutoGain>
+void LazirkoAudioProcessor::processMode(juce::AudioBuffer<SampleType>& buffer, int blockStart, int numSamples)
+{
+    constexpr bool twoStates = (Mode == LeftRight || Mode == MidSide);
+    constexpr bool channelActive = (Dephase || Damp);
+    constexpr int numSignals = twoStates ? 2 : 1;
+
+    const SampleType* inL = buffer.getReadPointer(0) + blockStart;
+    const SampleType* inR = buffer.getReadPointer(NumIns > 1 ? 1 : 0) + blockStart;
+
+    const auto dephase = smoothedDephasing.fillNextBlock(dephaseRampBuffer, numSamples);
+    const auto damp = smoothedDamping.fillNextBlock(dampRampBuffer, numSamples);
 
-    // Auto-gain
-    bool autoGainEnabled = (autoGainParam->load() > 0.5f);
-    if (autoGainEnabled && outputRMS > 1e-6f && inputRMS > 1e-6f)
-        smoothedGainCompensation.setTargetValue(juce::jlimit(0.1f, 10.0f, inputRMS / outputRMS));
+    ParameterRamp::Block gain, mix;
+
+    if constexpr (AutoGain)
+    {
+        gain = { gainRampBuffer, 1.0f };
+        mix = getMixRampValues(numSamples);
+    }
     else
+    {
         smoothedGainCompensation.setTargetValue(1.0f);
+        getMixRamps(numSamples, gain, mix);
+    }
 
-    // Mix
-    for (int n = 0; n < numSamples; ++n)
-{
-        float gainComp = smoothedGainCompensation.getNextValue();
-        float mixVal = smoothedMix.getNextValue();
+    for (int start = 0; start < numSamples; start += quantumChunkSize)
+    {
+        const int count = juce::jmin(quantumChunkSize, numSamples - start);
+        float* stateA = quantumStateA.re;
+        float* stateB = quantumStateB.re;
 
-        float dryL = dryBufferA[static_cast<size_t>(n)];
-        float dryR = dryBufferB[static_cast<size_t>(n)];
-        float wetL = wetBufferA[static_cast<size_t>(n)] * gainComp;
-        float wetR = wetBufferB[static_cast<size_t>(n)] * gainComp;
+        {
+            const TraceRecorder::ScopedEvent event(*tracer, "encode");
+            encodeChunk<Mode, NumIns>(inL + start, inR + start, filteredDryL + start, filteredDryR + start, count);
 
-        if (std::isnan(wetL) || std::isinf(wetL)) wetL = 0.0f;
-        if (std::isnan(wetR) || std::isinf(wetR)) wetR = 0.0f;
+            // Once encoded, the chunk's dry signal is replaced by the delayed one
+            if (oversamplingLatency > 0)
+            {
+                readDelayedInput(buffer, blockStart + start, blockStart + start, count);
 
-        float outL = dryL * (1.0f - mixVal) + wetL * mixVal;
-        float outR = dryR * (1.0f - mixVal) + wetR * mixVal;
+                if constexpr (Mode == TransientSustain)
+                {
+                    filteredDryDelay[0].process(filteredDryL + start, count);
+                    filteredDryDelay[1].process(filteredDryR + start, count);
+                }
+            }
+        }
 
-        if (totalNumOutputChannels >= 2)
+        // The channel works in place, so auto-gain measures its input from a copy
+        if constexpr (AutoGain && channelActive)
         {
-            buffer.setSample(0, n, outL);
-            buffer.setSample(1, n, outR);
+            const TraceRecorder::ScopedEvent event(*tracer, "copy");
+
+            std::memcpy(wetBufferA + start, stateA, sizeof(float) * static_cast<size_t>(count));
+            if constexpr (twoStates)
+                std::memcpy(wetBufferB + start, stateB, sizeof(float) * static_cast<size_t>(count));
+        }
+
+        if constexpr (channelActive)
+        {
+            applyQuantumChannel<Dephase, Damp>(quantumStateA, dephaseNoiseA, dephaseNoise, oversamplers[0],
+                                               dephase.from(start), damp.from(start), start, count);
+
+            if constexpr (twoStates)
+                applyQuantumChannel<Dephase, Damp>(quantumStateB, dephaseNoiseB, dephaseNoise, oversamplers[1],
+                                                   dephase.from(start), damp.from(start), start, count);
+        }
+        else
+        {
+            oversamplers[0].delay(stateA, count);
+
+            if constexpr (twoStates)
+                oversamplers[1].delay(stateB, count);
         }
-        else if (totalNumOutputChannels == 1)
+
+        if constexpr (AutoGain)
         {
-            buffer.setSample(0, n, (outL + outR) * 0.5f);
+            const TraceRecorder::ScopedEvent event(*tracer, "loudness");
+            const float* outputs[] = { stateA, stateB };
+
+            // With both stages off the channel is the identity
+            if constexpr (channelActive)
+            {
+                const float* inputs[] = { wetBufferA + start, wetBufferB + start };
+                followLoudness<numSignals>(inputs, outputs, start, count);
+            }
+            else
+            {
+                followLoudness<numSignals>(outputs, outputs, start, count);
+            }
         }
+
+        const TraceRecorder::ScopedEvent event(*tracer, "mix");
+        mixChunk<Mode, NumIns, NumOuts>(buffer, stateA, stateB, filteredDryL + start, filteredDryR + start,
+                                        gain.from(start), mix.from(start), blockStart + start, count);
     }
 }
 
-void LazirkoAudioProcessor::processMidSideMode(juce::AudioBuffer<float>& buffer, int numSamples)
+template <int Mode, int NumIns, typename SampleType>
+void LazirkoAudioProcessor::encodeChunk(const SampleType* inL, const SampleType* inR, float* sustainL, float* sustainR,
+    int numSamples)
 {
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    float* stateA = quantumStateA.re;
+    float* stateB = quantumStateB.re;
 
-    // Encode M/S
-    if (totalNumInputChannels >= 2)
-{
-        const float* leftIn = buffer.getReadPointer(0);
-        const float* rightIn = buffer.getReadPointer(1);
+    if constexpr (Mode == Mono)
+    {
+        // Sum to mono
         for (int n = 0; n < numSamples; ++n)
+            stateA[n] = static_cast<float>((NumIns > 1) ? inL[n] + inR[n] : inL[n]);
+    }
+    else if constexpr (Mode == LeftRight)
     {
-            float L = leftIn[n];
-            float R = rightIn[n];
-            dryBufferA[static_cast<size_t>(n)] = L + R;
-            dryBufferB[static_cast<size_t>(n)] = L - R;
+        copyToFloat(stateA, inL, numSamples);
+        copyToFloat(stateB, inR, numSamples);
+    }
+    else if constexpr (Mode == MidSide)
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            stateA[n] = static_cast<float>((NumIns > 1) ? inL[n] + inR[n] : inL[n]);
+            stateB[n] = static_cast<float>((NumIns > 1) ? inL[n] - inR[n] : SampleType());
         }
     }
-    else if (totalNumInputChannels == 1)
+    else
     {
-        std::memcpy(dryBufferA.data(), buffer.getReadPointer(0),
-            sizeof(float) * static_cast<size_t>(numSamples));
-        std::memset(dryBufferB.data(), 0, sizeof(float) * static_cast<size_t>(numSamples));
+        // Split transient/sustain; the sustain goes to quantum processing
+        splitSustain(inL, inR, sustainL, sustainR, numSamples);
+
+        for (int n = 0; n < numSamples; ++n)
+            stateA[n] = (sustainL[n] + sustainR[n]) * 0.5f;
+    }
 }
 
-    float midInRMS = calculateRMS(dryBufferA.data(), numSamples);
-    float sideInRMS = calculateRMS(dryBufferB.data(), numSamples);
-    inputRMS = (midInRMS + sideInRMS) * 0.5f;
+template <typename SampleType>
+void LazirkoAudioProcessor::splitSustain(const SampleType* inL, const SampleType* inR, float* sustainL, float* sustainR,
+    int numSamples)
+{
+    const SampleType* inputs[] = { inL, inR };
+    float* outputs[] = { sustainL, sustainR };
+
+    transientFilterLP.process(inputs, outputs, numSamples);
+}
 
-    // Encode
-    for (int n = 0; n < numSamples; ++n)
+//==============================================================================
+template <typename SampleType, int NumIns, int NumOuts, bool Dephase, bool Damp, bool AutoGain>
+void LazirkoAudioProcessor::processMultiband(juce::AudioBuffer<SampleType>& buffer, int blockStart, int numSamples)
 {
-        quantumStateA[static_cast<size_t>(n)] = Complex(dryBufferA[static_cast<size_t>(n)], 0.0);
-        quantumStateB[static_cast<size_t>(n)] = Complex(dryBufferB[static_cast<size_t>(n)], 0.0);
+    const SampleType* inL = buffer.getReadPointer(0) + blockStart;
+    const SampleType* inR = buffer.getReadPointer(NumIns > 1 ? 1 : 0) + blockStart;
+
+    {
+        const TraceRecorder::ScopedEvent event(*tracer, "split");
+        splitBands(inL, inR, numSamples);
+
+        if (oversamplingLatency > 0)
+        {
+            filteredDryDelay[0].process(filteredDryL, numSamples);
+            filteredDryDelay[1].process(filteredDryR, numSamples);
+        }
+    }
+
+    blockDephase = smoothedDephasing.fillNextBlock(dephaseRampBuffer, numSamples);
+    blockDamp = smoothedDamping.fillNextBlock(dampRampBuffer, numSamples);
+
+    if constexpr (Dephase || Damp)
+    {
+        for (size_t band = 0; band < static_cast<size_t>(numBands); ++band)
+        {
+            bandDephaseScale[band] = juce::jlimit(0.0f, 1.0f, *bandDephasingParams[band]);
+            bandDampScale[band] = juce::jlimit(0.0f, 1.0f, *bandDampingParams[band]);
+        }
+
+        bandJobNumSamples = numSamples;
+
+        const TraceRecorder::ScopedEvent event(*tracer, "bands");
+
+        // Without the workers, or while another instance has them, the bands run here
+        auto* workers = bandWorkers.load(std::memory_order_acquire);
+
+        if (workers == nullptr || *parallelBandsParam <= 0.5f || numSamples < minParallelBandBlockSize
+            || ! workers->run(&LazirkoAudioProcessor::runBandJob<NumIns, Dephase, Damp>, this, numBands))
+        {
+            for (int band = 0; band < numBands; ++band)
+                processBand<NumIns, Dephase, Damp>(band, numSamples);
+        }
+    }
+    else
+    {
+        for (int band = 0; band < numBands; ++band)
+            for (int channel = 0; channel < NumIns; ++channel)
+                getBandOversampler(channel, band).delay(getBandSignal(channel, band), numSamples);
     }
 
-    // Process
-    float dephase = smoothedDephasing.getCurrentValue();
-    float damp = smoothedDamping.getCurrentValue();
-    applyQuantumChannel(quantumStateA, dephase, damp, numSamples);
-    applyQuantumChannel(quantumStateB, dephase, damp, numSamples);
+    // Sum the processed bands into the wet buffers
+    float* wet[] = { wetBufferA, wetBufferB };
 
-    // Decode
-    for (int n = 0; n < numSamples; ++n)
+    for (int channel = 0; channel < NumIns; ++channel)
     {
-        wetBufferA[static_cast<size_t>(n)] = static_cast<float>(quantumStateA[static_cast<size_t>(n)].real());
-        wetBufferB[static_cast<size_t>(n)] = static_cast<float>(quantumStateB[static_cast<size_t>(n)].real());
+        const TraceRecorder::ScopedEvent event(*tracer, "sum");
+
+        float* sum = wet[channel];
+        std::memcpy(sum, getBandSignal(channel, 0), sizeof(float) * static_cast<size_t>(numSamples));
+
+        for (int band = 1; band < numBands; ++band)
+        {
+            const float* signal = getBandSignal(channel, band);
+
+            for (int n = 0; n < numSamples; ++n)
+                sum[n] += signal[n];
+        }
     }
 
-    float midOutRMS = calculateRMS(wetBufferA.data(), numSamples);
-    float sideOutRMS = calculateRMS(wetBufferB.data(), numSamples);
-    outputRMS = (midOutRMS + sideOutRMS) * 0.5f;
+    ParameterRamp::Block gain, mix;
 
-    // Auto-gain
-    bool autoGainEnabled = (autoGainParam->load() > 0.5f);
-    if (autoGainEnabled && outputRMS > 1e-6f && inputRMS > 1e-6f)
-        smoothedGainCompensation.setTargetValue(juce::jlimit(0.1f, 10.0f, inputRMS / outputRMS));
+    if constexpr (AutoGain)
+    {
+        gain = { gainRampBuffer, 1.0f };
+        mix = getMixRampValues(numSamples);
+    }
     else
+    {
         smoothedGainCompensation.setTargetValue(1.0f);
+        getMixRamps(numSamples, gain, mix);
+    }
 
-    // Decode M/S to L/R
-    if (totalNumOutputChannels >= 2)
+    for (int start = 0; start < numSamples; start += quantumChunkSize)
     {
-        float* leftOut = buffer.getWritePointer(0);
-        float* rightOut = buffer.getWritePointer(1);
+        const int count = juce::jmin(quantumChunkSize, numSamples - start);
 
-        for (int n = 0; n < numSamples; ++n)
+        if constexpr (AutoGain)
+        {
+            const TraceRecorder::ScopedEvent event(*tracer, "loudness");
+            const float* inputs[] = { filteredDryL + start, filteredDryR + start };
+            const float* outputs[] = { wetBufferA + start, wetBufferB + start };
+            followLoudness<NumIns>(inputs, outputs, start, count);
+        }
+
+        const TraceRecorder::ScopedEvent event(*tracer, "mix");
+        mixChunk<Multiband, NumIns, NumOuts>(buffer, wetBufferA + start, wetBufferB + start,
+                                             filteredDryL + start, filteredDryR + start,
+                                             gain.from(start), mix.from(start), blockStart + start, count);
+    }
+}
+
+template <int NumIns, bool Dephase, bool Damp>
+void LazirkoAudioProcessor::processBand(int band, int numSamples)
 {
-            float gainComp = smoothedGainCompensation.getNextValue();
-            float mixVal = smoothedMix.getNextValue();
+    const auto index = static_cast<size_t>(band);
+    const float dephaseScale = bandDephaseScale[index];
+    const float dampScale = bandDampScale[index];
+    const bool dephaseActive = Dephase && dephaseScale > 1e-6f
+                            && (! blockDephase.isConstant() || blockDephase.value * dephaseScale > 1e-6f);
+    const bool dampActive = Damp && dampScale > 1e-6f
+                         && (! blockDamp.isConstant() || blockDamp.value * dampScale > 1e-6f);
+
+    if (! (dephaseActive || dampActive))
+    {
+        for (int channel = 0; channel < NumIns; ++channel)
+            getBandOversampler(channel, band).delay(getBandSignal(channel, band), numSamples);
 
-            float dryM = dryBufferA[static_cast<size_t>(n)];
-            float dryS = dryBufferB[static_cast<size_t>(n)];
-            float wetM = wetBufferA[static_cast<size_t>(n)] * gainComp;
-            float wetS = wetBufferB[static_cast<size_t>(n)] * gainComp;
+        return;
+    }
 
-            if (std::isnan(wetM) || std::isinf(wetM)) wetM = 0.0f;
-            if (std::isnan(wetS) || std::isinf(wetS)) wetS = 0.0f;
+    const TraceRecorder::ScopedEvent event(*tracer, "band");
 
-            float finalM = dryM * (1.0f - mixVal) + wetM * mixVal;
-            float finalS = dryS * (1.0f - mixVal) + wetS * mixVal;
+    // The band's share of a ramping global amount goes into its own chunk buffer
+    auto scaleChunk = [] (const ParameterRamp::Block& global, float scale, float* dest, int start, int count)
+    {
+        if (global.isConstant())
+            return ParameterRamp::Block { nullptr, global.value * scale };
 
-            leftOut[n] = (finalM + finalS) * 0.5f;
-            rightOut[n] = (finalM - finalS) * 0.5f;
+        for (int n = 0; n < count; ++n)
+            dest[n] = global.values[start + n] * scale;
+
+        return ParameterRamp::Block { dest, global.value * scale };
+    };
+
+    for (int start = 0; start < numSamples; start += quantumChunkSize)
+    {
+        const int count = juce::jmin(quantumChunkSize, numSamples - start);
+        const auto dephase = scaleChunk(blockDephase, dephaseScale, bandDephaseRamps[index], start, count);
+        const auto damp = scaleChunk(blockDamp, dampScale, bandDampRamps[index], start, count);
+
+        // Each band and channel has its own noise stream, so the result does not
+        // depend on which thread runs the band
+        for (int channel = 0; channel < NumIns; ++channel)
+        {
+            QuantumState state { getBandSignal(channel, band) + start, bandImaginary[index] };
+            auto& noise = bandNoise[static_cast<size_t>(channel * maxBands + band)];
+            auto& oversampler = getBandOversampler(channel, band);
+            float* noiseBuffer = bandNoiseBuffers[index];
+
+            if (dephaseActive && dampActive)
+                applyQuantumChannel<true, true>(state, noise, noiseBuffer, oversampler, dephase, damp, start, count);
+            else if (dephaseActive)
+                applyQuantumChannel<true, false>(state, noise, noiseBuffer, oversampler, dephase, damp, start, count);
+            else
+                applyQuantumChannel<false, true>(state, noise, noiseBuffer, oversampler, dephase, damp, start, count);
         }
     }
-    else if (totalNumOutputChannels == 1)
+}
+
+template <int NumIns, bool Dephase, bool Damp>
+void LazirkoAudioProcessor::runBandJob(void* processor, int band)
+{
+    auto& self = *static_cast<LazirkoAudioProcessor*>(processor);
+    self.processBand<NumIns, Dephase, Damp>(band, self.bandJobNumSamples);
+}
+
+template <typename SampleType>
+void LazirkoAudioProcessor::splitBands(const SampleType* inL, const SampleType* inR, int numSamples)
+{
+    const size_t numBytes = sizeof(float) * static_cast<size_t>(numSamples);
+
+    // The top band starts as the whole input; each crossover splits its low band off
+    float* restL = getBandSignal(0, numBands - 1);
+    float* restR = getBandSignal(1, numBands - 1);
+    copyToFloat(restL, inL, numSamples);
+    copyToFloat(restR, inR, numSamples);
+
+    for (int c = 0; c < numBands - 1; ++c)
     {
-        float* output = buffer.getWritePointer(0);
-        for (int n = 0; n < numSamples; ++n)
-        {
-            float gainComp = smoothedGainCompensation.getNextValue();
-            float mixVal = smoothedMix.getNextValue();
+        const float* inputs[] = { restL, restL, restR, restR };
+        float* outputs[] = { getBandSignal(0, c), restL, getBandSignal(1, c), restR };
 
-            float dryM = dryBufferA[static_cast<size_t>(n)];
-            float wetM = wetBufferA[static_cast<size_t>(n)] * gainComp;
+        crossoverSection1[static_cast<size_t>(c)].process(inputs, outputs, numSamples);
+        crossoverSection2[static_cast<size_t>(c)].process(outputs, outputs, numSamples);
+    }
 
-            if (std::isnan(wetM) || std::isinf(wetM)) wetM = 0.0f;
+    for (int round = 0; round < numBands - 2; ++round)
+    {
+        const int bandsInRound = numBands - 2 - round;
+        float* signals[2 * (maxBands - 2)] = {};
 
-            output[n] = dryM * (1.0f - mixVal) + wetM * mixVal;
-        }
+        for (int band = 0; band < bandsInRound; ++band)
+        {
+            signals[band * 2] = getBandSignal(0, band);
+            signals[band * 2 + 1] = getBandSignal(1, band);
         }
+
+        crossoverAllpass[static_cast<size_t>(round)].process(signals, signals, numSamples, bandsInRound * 2);
     }
 
-void LazirkoAudioProcessor::processTransientSustainMode(juce::AudioBuffer<float>& buffer, int numSamples)
+    // The dry side of the mix
+    std::memcpy(filteredDryL, getBandSignal(0, 0), numBytes);
+    std::memcpy(filteredDryR, getBandSignal(1, 0), numBytes);
+
+    for (int band = 1; band < numBands; ++band)
+    {
+        const float* bandL = getBandSignal(0, band);
+        const float* bandR = getBandSignal(1, band);
+
+        for (int n = 0; n < numSamples; ++n)
         {
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+            filteredDryL[n] += bandL[n];
+            filteredDryR[n] += bandR[n];
+        }
+    }
+}
 
-    const float* inL = buffer.getReadPointer(0);
-    const float* inR = (totalNumInputChannels > 1) ? buffer.getReadPointer(1) : inL;
+void LazirkoAudioProcessor::getMixRamps(int numSamples, ParameterRamp::Block& gain, ParameterRamp::Block& mix)
+{
+    gain = smoothedGainCompensation.fillNextBlock(gainRampBuffer, numSamples);
+    mix = smoothedMix.fillNextBlock(mixRampBuffer, numSamples);
 
-    // QUANTUM FIX: Coherent filter state preservation via Lindblad decoherence operator
-    // Store filter states before first pass to maintain phase continuity
-    auto hpL_state = transientFilterHP_L;
-    auto hpR_state = transientFilterHP_R;
-    auto lpL_state = transientFilterLP_L;
-    auto lpR_state = transientFilterLP_R;
+    // If only one of them moves, the mix loops still want two arrays
+    if (gain.isConstant() != mix.isConstant())
+    {
+        auto& constant = gain.isConstant() ? gain : mix;
+        float* dest = gain.isConstant() ? gainRampBuffer : mixRampBuffer;
 
-    // Split transient/sustain and store
-    for (int n = 0; n < numSamples; ++n)
-            {
-        float l = inL[n];
-        float r = inR[n];
+        std::fill(dest, dest + numSamples, constant.value);
+        constant.values = dest;
+    }
+}
 
-        float lLP = transientFilterLP_L.process(l);
-        float rLP = transientFilterLP_R.process(r);
+ParameterRamp::Block LazirkoAudioProcessor::getMixRampValues(int numSamples)
+{
+    auto mix = smoothedMix.fillNextBlock(mixRampBuffer, numSamples);
 
-        // Store sustain (for quantum processing)
-        dryBufferA[static_cast<size_t>(n)] = (lLP + rLP) * 0.5f;
+    if (mix.isConstant())
+    {
+        std::fill(mixRampBuffer, mixRampBuffer + numSamples, mix.value);
+        mix.values = mixRampBuffer;
     }
 
-    inputRMS = calculateRMS(dryBufferA.data(), numSamples);
+    return mix;
+}
 
-    // Encode sustain
-    for (int n = 0; n < numSamples; ++n)
-        quantumStateA[static_cast<size_t>(n)] = Complex(dryBufferA[static_cast<size_t>(n)], 0.0);
+template <int NumSignals>
+void LazirkoAudioProcessor::followLoudness(const float* const* inputs, const float* const* outputs, int startSample,
+    int numSamples)
+{
+    // The gain target moves at hop boundaries, so each piece ends at one
+    for (int done = 0; done < numSamples;)
+    {
+        const int count = juce::jmin(numSamples - done, loudness.getSamplesToHopEnd());
+        float* gains = gainRampBuffer + startSample + done;
 
-    // Process sustain
-    float dephase = smoothedDephasing.getCurrentValue();
-    float damp = smoothedDamping.getCurrentValue();
-    applyQuantumChannel(quantumStateA, dephase, damp, numSamples);
+        const auto gain = smoothedGainCompensation.fillNextBlock(gains, count);
+        if (gain.isConstant())
+            std::fill(gains, gains + count, gain.value);
 
-    // Decode
-    for (int n = 0; n < numSamples; ++n)
-        wetBufferA[static_cast<size_t>(n)] = static_cast<float>(quantumStateA[static_cast<size_t>(n)].real());
+        if (loudness.add<NumSignals>(inputs, outputs, done, count))
+            smoothedGainCompensation.setTargetValue(loudness.getGainCompensation());
 
-    outputRMS = calculateRMS(wetBufferA.data(), numSamples);
+        done += count;
+    }
+}
 
-    // Auto-gain
-    bool autoGainEnabled = (autoGainParam->load() > 0.5f);
-    if (autoGainEnabled && outputRMS > 1e-6f && inputRMS > 1e-6f)
-        smoothedGainCompensation.setTargetValue(juce::jlimit(0.1f, 10.0f, inputRMS / outputRMS));
+template <int Mode, int NumIns, int NumOuts, typename SampleType>
+void LazirkoAudioProcessor::mixChunk(juce::AudioBuffer<SampleType>& buffer, const float* wetA, const float* wetB,
+    const float* filteredL, const float* filteredR, const ParameterRamp::Block& gain,
+    const ParameterRamp::Block& mix, int startSample, int numSamples)
+{
+    if (gain.isConstant())
+        mixSamples<Mode, NumIns, NumOuts>(buffer, wetA, wetB, filteredL, filteredR,
+                                          ConstantRamp { gain.value }, ConstantRamp { mix.value }, startSample, numSamples);
     else
-        smoothedGainCompensation.setTargetValue(1.0f);
+        mixSamples<Mode, NumIns, NumOuts>(buffer, wetA, wetB, filteredL, filteredR,
+                                          gain.values, mix.values, startSample, numSamples);
+}
 
-    // QUANTUM FIX: Restore filter states instead of hard reset
-    // This preserves phase coherence (superposition) across the re-processing pass
-    transientFilterHP_L = hpL_state;
-    transientFilterHP_R = hpR_state;
-    transientFilterLP_L = lpL_state;
-    transientFilterLP_R = lpR_state;
+template <int Mode, int NumIns, int NumOuts, typename SampleType, typename Ramp>
+void LazirkoAudioProcessor::mixSamples(juce::AudioBuffer<SampleType>& buffer, const float* wetA, const float* wetB,
+    const float* filteredL, const float* filteredR, Ramp gainRamp, Ramp mixRamp, int startSample, int numSamples)
+{
+    // Reads and writes share the host channels, always at the same index
+    SampleType* left = buffer.getWritePointer(0) + startSample;
+    SampleType* right = buffer.getWritePointer(juce::jmax(NumIns, NumOuts) > 1 ? 1 : 0) + startSample;
 
-    // Reconstruct
-    float* outL = buffer.getWritePointer(0);
-    float* outR = (totalNumOutputChannels > 1) ? buffer.getWritePointer(1) : outL;
+    if constexpr (Mode == Mono)
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const SampleType dry = (NumIns > 1) ? left[n] + right[n] : left[n];
+            const float wet = zeroIfNotFinite(wetA[n] * gainRamp[n]);
+            const SampleType output = dry * (1.0f - mixRamp[n]) + wet * mixRamp[n];
 
-    for (int n = 0; n < numSamples; ++n)
+            left[n] = output;
+            if constexpr (NumOuts > 1)
+                right[n] = output;
+        }
+    }
+    else if constexpr (Mode == LeftRight)
     {
-        float gainComp = smoothedGainCompensation.getNextValue();
-        float mixVal = smoothedMix.getNextValue();
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const SampleType dryL = left[n];
+            const SampleType dryR = (NumIns > 1) ? right[n] : left[n];
+            const float wetL = zeroIfNotFinite(wetA[n] * gainRamp[n]);
+            const float wetR = zeroIfNotFinite(wetB[n] * gainRamp[n]);
+
+            const SampleType outL = dryL * (1.0f - mixRamp[n]) + wetL * mixRamp[n];
+            const SampleType outR = dryR * (1.0f - mixRamp[n]) + wetR * mixRamp[n];
 
-        float l = inL[n];
-        float r = inR[n];
+            if constexpr (NumOuts > 1)
+            {
+                left[n] = outL;
+                right[n] = outR;
+            }
+            else
+            {
+                left[n] = (outL + outR) * 0.5f;
+            }
+        }
+    }
+    else if constexpr (Mode == MidSide)
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const SampleType dryM = (NumIns > 1) ? left[n] + right[n] : left[n];
+            const SampleType dryS = (NumIns > 1) ? left[n] - right[n] : 0.0f;
+            const float wetM = zeroIfNotFinite(wetA[n] * gainRamp[n]);
+            const float wetS = zeroIfNotFinite(wetB[n] * gainRamp[n]);
 
-        // Re-split with preserved filter state continuity
-        float lHP = transientFilterHP_L.process(l);
-        float lLP = transientFilterLP_L.process(l);
-        float rHP = transientFilterHP_R.process(r);
-        float rLP = transientFilterLP_R.process(r);
+            const SampleType finalM = dryM * (1.0f - mixRamp[n]) + wetM * mixRamp[n];
+            const SampleType finalS = dryS * (1.0f - mixRamp[n]) + wetS * mixRamp[n];
 
-        // Processed sustain
-        float processedSustain = wetBufferA[static_cast<size_t>(n)] * gainComp;
+            // Decode M/S to L/R; a mono output only gets the mid signal
+            if constexpr (NumOuts > 1)
+            {
+                left[n] = (finalM + finalS) * 0.5f;
+                right[n] = (finalM - finalS) * 0.5f;
+            }
+            else
+            {
+                left[n] = finalM;
+            }
+        }
+    }
+    else if constexpr (Mode == TransientSustain)
+    {
+        // Reconstruct: the transients are the complement of the sustain band, so
+        // transients plus the dry sustain give back the input
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const SampleType l = left[n];
+            const SampleType r = (NumIns > 1) ? right[n] : left[n];
 
-        if (std::isnan(processedSustain) || std::isinf(processedSustain))
-            processedSustain = 0.0f;
+            const float lLP = filteredL[n];
+            const float rLP = filteredR[n];
+            const SampleType lHP = l - lLP;
+            const SampleType rHP = r - rLP;
 
-        // Mix sustain, keep transients dry
-        float finalSustainL = lLP * (1.0f - mixVal) + processedSustain * mixVal;
-        float finalSustainR = rLP * (1.0f - mixVal) + processedSustain * mixVal;
+            // Mix sustain, keep transients dry
+            const float processedSustain = zeroIfNotFinite(wetA[n] * gainRamp[n]);
+            const SampleType finalSustainL = lLP * (1.0f - mixRamp[n]) + processedSustain * mixRamp[n];
+            const SampleType finalSustainR = rLP * (1.0f - mixRamp[n]) + processedSustain * mixRamp[n];
 
-        outL[n] = lHP + finalSustainL;
-        outR[n] = rHP + finalSustainR;
+            if constexpr (NumOuts > 1)
+            {
+                left[n] = lHP + finalSustainL;
+                right[n] = rHP + finalSustainR;
+            }
+            else
+            {
+                left[n] = rHP + finalSustainR;
+            }
+        }
     }
+    else
+    {
+        // The dry side is the sum of the unprocessed bands rather than the input, so
+        // it carries the same crossover phase response as the wet side
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const SampleType dryL = filteredL[n];
+            const SampleType dryR = (NumIns > 1) ? filteredR[n] : filteredL[n];
+            const float wetL = zeroIfNotFinite(wetA[n] * gainRamp[n]);
+            const float wetR = (NumIns > 1) ? zeroIfNotFinite(wetB[n] * gainRamp[n]) : wetL;
+
+            const SampleType outL = dryL * (1.0f - mixRamp[n]) + wetL * mixRamp[n];
+            const SampleType outR = dryR * (1.0f - mixRamp[n]) + wetR * mixRamp[n];
+
+            if constexpr (NumOuts > 1)
+            {
+                left[n] = outL;
+                right[n] = outR;
+            }
+            else
+            {
+                left[n] = (outL + outR) * 0.5f;
+            }
+        }
     }
+}
 
 juce::AudioProcessorEditor* LazirkoAudioProcessor::createEditor()
 {
-    return new juce::GenericAudioProcessorEditor(*this);
+   #if LAZIRKO_HEADLESS
+    return nullptr;
+   #else
+    return new LazirkoAudioProcessorEditor(*this);
+   #endif
 }
 
 bool LazirkoAudioProcessor::hasEditor() const
 {
+   #if LAZIRKO_HEADLESS
+    return false;
+   #else
     return true;
+   #endif
 }
 
 void LazirkoAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
@@ -1,10 +1,37 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <complex>
-#include <vector>
+#include <array>
+#include <utility>
 #include <cmath>
 
+#include "BiquadBank.h"
+#include "CpuProfiler.h"
+#include "LoudnessWindow.h"
+#include "Oversampler.h"
+#include "ParameterEventQueue.h"
+#include "ParameterRamp.h"
+#include "QuantumKernels.h"
+#include "QuantumNoise.h"
+#include "RealtimeWorkerPool.h"
+#include "SampleDelay.h"
+#include "TelemetryQueue.h"
+#include "TraceRecorder.h"
+
+// Set by builds that only link the headless audio modules, such as the render CLI.
+// Those builds have no editor and no JucePluginDefines.h.
+#ifndef LAZIRKO_HEADLESS
+ #define LAZIRKO_HEADLESS 0
+#endif
+
+#if LAZIRKO_HEADLESS && ! defined (JucePlugin_Name)
+ #define JucePlugin_Name                   "Quantum Noise Channel"
+ #define JucePlugin_IsSynth                0
+ #define JucePlugin_WantsMidiInput         0
+ #define JucePlugin_ProducesMidiOutput     0
+ #define JucePlugin_IsMidiEffect           0
+#endif
+
 class LazirkoAudioProcessor : public juce::AudioProcessor
 {
 public:
@@ -19,6 +46,11 @@ public:
    #endif
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    juce::AudioProcessorParameter* getBypassParameter() const override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
 
@@ -38,90 +70,396 @@ public:
 
     juce::AudioProcessorValueTreeState& getAPVTS() { return parameters; }
 
+    /** The dephasing noise is a pure function of this seed and the sample position,
+        so renders that split the timeline can reproduce a serial render exactly.
+        Each instance starts with a random seed and at position 0. */
+    void setNoiseSeed(juce::uint64 seed);
+
+    /** Sets the sample position the next processed block starts at. */
+    void setNoisePosition(juce::uint64 samplePosition) { noisePosition = samplePosition; }
+    juce::uint64 getNoisePosition() const              { return noisePosition; }
+
+    /** How long an instance has to run on the stream before a position for its output
+        from there on to match, to the last bit, that of an instance that has run since
+        the start: the filter states and parameter ramps have settled by then. With
+        auto-gain, the loudness window has to fill and its gain ramp settle as well. */
+    static constexpr double settlingSeconds = 1.0;
+    static constexpr double autoGainSettlingSeconds = 2.0;
+
+    /** True while the input is silent and the filter tails have died away; such
+        blocks pass through without running the DSP. */
+    bool isIdle() const noexcept { return tailDecayed; }
+
+    /** True if prepareToPlay chose the render tier: the precise kernels, with exact
+        trigonometry. The QUALITY setting picks it, or Auto while the host renders
+        offline. Only an explicit Render also oversamples damping at least 4x with
+        linear-phase filters, so that Auto keeps the latency of playback. */
+    bool isRenderQuality() const noexcept { return renderQuality; }
+
+    /** Schedules a change of a parameter's plain value at a sample offset into the
+        next processed block, for callers that know where in the block it belongs.
+        The parameter object itself is not touched. Changes made through the
+        parameters take effect at the start of the next block. */
+    bool queueParameterChange(const juce::String& parameterID, float value, int sampleOffset);
+
+    /** Per-block levels and settings for the editor's meters. Blocks are measured
+        only while the queue is enabled. */
+    TelemetryQueue& getTelemetry() noexcept { return telemetry; }
+
+    /** Time spent in processBlock, the mode processors and the quantum channel,
+        against the real-time budget. Nothing is timed while it is disabled. */
+    CpuProfiler& getProfiler() noexcept { return profiler; }
+
+    /** Timeline of the processing stages of every block, for a trace viewer.
+        Nothing is recorded until it is started. */
+    TraceRecorder& getTracer() noexcept { return *tracer; }
+
+    /** Records into another recorder, as when several processors render one file
+        together; nullptr goes back to the processor's own. Call while not processing. */
+    void setTracer(TraceRecorder* recorderToUse) noexcept { tracer = recorderToUse != nullptr ? recorderToUse : &ownTracer; }
+
     enum ProcessingMode
     {
         Mono = 1,
         LeftRight = 2,
         MidSide = 3,
-        TransientSustain = 4
+        TransientSustain = 4,
+        Multiband = 5
     };
 
+    static constexpr int minBands = 3;
+    static constexpr int maxBands = 8;
+
 private:
-    using Complex = std::complex<double>;
+    // Quantum state as split real/imaginary arrays for the SIMD kernels
+    struct QuantumState
+    {
+        float* re = nullptr;
+        float* im = nullptr;
+    };
+
+    // Samples processed per fused pass; small enough to stay in L1
+    static constexpr int quantumChunkSize = 256;
+
+    // Shorter blocks run their bands serially; waking workers would cost more than it saves
+    static constexpr int minParallelBandBlockSize = 512;
+
+    // Input below -120 dBFS counts as silence. The T/S low-pass and the crossovers
+    // ring on after the input stops; the lowest crossover (84 Hz with 8 bands)
+    // takes about 40 ms to fall that far, which tailLengthSeconds rounds up.
+    static constexpr float silenceThreshold = 1.0e-6f;
+    static constexpr double tailLengthSeconds = 0.1;
 
-    // Pre-allocated buffers
-    std::vector<Complex> quantumStateA;
-    std::vector<Complex> quantumStateB;
-    std::vector<float> dryBufferA;
-    std::vector<float> dryBufferB;
-    std::vector<float> wetBufferA;
-    std::vector<float> wetBufferB;
+    // Bypass changes crossfade over this long
+    static constexpr double bypassFadeSeconds = 0.01;
 
-    int lastBlockSize = 0;
+    // All scratch buffers live in one aligned arena that prepareToPlay allocates.
+    // Quantum states and noise hold one chunk; the wet, filtered dry, band and
+    // parameter ramp buffers hold maxBlockSize samples. Larger host blocks are processed as several
+    // sub-blocks of at most maxBlockSize samples.
+    juce::HeapBlock<float> scratchArena;
+    int maxBlockSize = 0;
+
+    QuantumState quantumStateA;
+    QuantumState quantumStateB;
+    float* dephaseNoise = nullptr;
+    float* wetBufferA = nullptr;
+    float* wetBufferB = nullptr;
+
+    // Per-sample parameter values of the current sub-block, written only while a
+    // parameter is ramping
+    float* dephaseRampBuffer = nullptr;
+    float* dampRampBuffer = nullptr;
+    float* gainRampBuffer = nullptr;
+    float* mixRampBuffer = nullptr;
+
+    // Dry signal after the split filters: the sustain band in T/S mode, the sum of
+    // the unprocessed bands in multiband mode
+    float* filteredDryL = nullptr;
+    float* filteredDryR = nullptr;
+
+    // Multiband signals, structure-of-arrays: one contiguous block per channel and
+    // band. The channel runs in place on them, with a chunk of imaginary part and
+    // noise per band so that bands can run on different threads.
+    float* bandSignals = nullptr;
+    size_t bandStride = 0;
+    std::array<float*, maxBands> bandImaginary {};
+    std::array<float*, maxBands> bandNoiseBuffers {};
+    std::array<float*, maxBands> bandDephaseRamps {};
+    std::array<float*, maxBands> bandDampRamps {};
 
     juce::AudioProcessorValueTreeState parameters;
-    std::atomic<float>* dephasingParam = nullptr;
-    std::atomic<float>* dampingParam = nullptr;
-    std::atomic<float>* mixParam = nullptr;
-    std::atomic<float>* autoGainParam = nullptr;
-    std::atomic<float>* modeParam = nullptr;
+
+    // The audio thread's view of the parameters. Listeners on every parameter post
+    // changes to parameterEvents; processBlock applies them to parameterValues at
+    // their sample offsets and splits the block there, so the values are constant
+    // over each segment. The pointers below point into parameterValues.
+    class ParameterForwarder;
+
+    juce::StringArray parameterIDs;
+    std::vector<std::atomic<float>*> parameterSources;
+    std::vector<float> parameterValues;
+    std::vector<std::unique_ptr<ParameterForwarder>> parameterForwarders;
+    ParameterEventQueue parameterEvents;
+    std::array<ParameterEvent, ParameterEventQueue::capacity> pendingEvents;
+
+    const float* dephasingParam = nullptr;
+    const float* dampingParam = nullptr;
+    const float* mixParam = nullptr;
+    const float* autoGainParam = nullptr;
+    const float* modeParam = nullptr;
+    const float* numBandsParam = nullptr;
+    const float* parallelBandsParam = nullptr;
+    const float* bypassParam = nullptr;
+    const float* oversamplingParam = nullptr;
+    const float* oversamplingFilterParam = nullptr;
+    const float* qualityParam = nullptr;
+    std::array<const float*, maxBands> bandDephasingParams {};
+    std::array<const float*, maxBands> bandDampingParams {};
 
     // Parameter smoothing
-    juce::SmoothedValue<float> smoothedDephasing;
-    juce::SmoothedValue<float> smoothedDamping;
-    juce::SmoothedValue<float> smoothedMix;
-    juce::SmoothedValue<float> smoothedGainCompensation;
+    ParameterRamp smoothedDephasing;
+    ParameterRamp smoothedDamping;
+    ParameterRamp smoothedMix;
+    ParameterRamp smoothedGainCompensation;
+
+    // Loudness of the signal into and out of the channel, while auto-gain is on
+    LoudnessWindow loudness;
+    bool followingLoudness = false;
+
+    TelemetryQueue telemetry;
+    CpuProfiler profiler;
+    TraceRecorder ownTracer;
+    TraceRecorder* tracer = &ownTracer;
 
-    // RMS measurement
-    float inputRMS = 0.0f;
-    float outputRMS = 0.0f;
+    // Set after a silent block once the filters have decayed; from then on silent
+    // blocks skip the DSP until the input comes back
+    bool tailDecayed = true;
 
-    // Simple IIR filters for T/S mode
-    struct SimpleFilter
+    // 0 = processed, 1 = bypassed. While it moves, the dry input of the fade is
+    // kept in the buffer of the host's sample type.
+    ParameterRamp bypassFade;
+    juce::HeapBlock<float> bypassFadeGains;
+    juce::AudioBuffer<float> bypassDryFloat;
+    juce::AudioBuffer<double> bypassDryDouble;
+    int bypassFadeLength = 0;
+
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType>& getBypassDryBuffer() noexcept
     {
-        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
-        float a1 = 0.0f, a2 = 0.0f;
-        float x1 = 0.0f, x2 = 0.0f;
-        float y1 = 0.0f, y2 = 0.0f;
-
-        void setCoefficients(float _b0, float _b1, float _b2, float _a1, float _a2)
-        {
-            b0 = _b0; b1 = _b1; b2 = _b2;
-            a1 = _a1; a2 = _a2;
-        }
-
-        void reset()
-        {
-            x1 = x2 = y1 = y2 = 0.0f;
-        }
-
-        float process(float input)
-        {
-            float output = b0 * input + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-            x2 = x1; x1 = input;
-            y2 = y1; y1 = output;
-            return output;
-        }
-    };
+        if constexpr (std::is_same_v<SampleType, float>)
+            return bypassDryFloat;
+        else
+            return bypassDryDouble;
+    }
+
+    // Oversampling of the damping stage: one oversampler per quantum state (0 and 1)
+    // and per channel and band. prepareToPlay sets them up from the OVERSAMPLING
+    // settings; changing those only reports the new latency, so that the host
+    // prepares again. Whatever bypasses the oversamplers (the host's input, the
+    // filtered dry signals, the delay path of stages that are off) is delayed by
+    // the same latency, so dry and wet stay aligned.
+    class LatencyUpdater;
+
+    std::array<Oversampler, 2 + 2 * maxBands> oversamplers;
+    int oversamplingLatency = 0;
+    std::unique_ptr<LatencyUpdater> latencyUpdater;
+
+    Oversampler& getBandOversampler(int channel, int band) noexcept
+    {
+        return oversamplers[static_cast<size_t>(2 + channel * maxBands + band)];
+    }
+
+    // The input of every host block is pushed whole, in the host's sample type, and
+    // read back delayed wherever the dry signal is used
+    std::array<SampleDelay<float>, 2> inputDelayFloat;
+    std::array<SampleDelay<double>, 2> inputDelayDouble;
+    std::array<SampleDelay<float>, 2> filteredDryDelay;
+    int inputDelayBlockLength = 0;
+
+    // False once anything has gone through the delays, until they are cleared
+    bool delaysClear = true;
+
+    template <typename SampleType>
+    std::array<SampleDelay<SampleType>, 2>& getInputDelays() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return inputDelayFloat;
+        else
+            return inputDelayDouble;
+    }
+
+    // Low-pass of the T/S split, L and R in one filter bank; the transient band
+    // is the input minus the low-passed sustain band
+    BiquadBank<2> transientFilterLP;
+
+    // Linkwitz-Riley crossovers of the multiband mode. Each LR4 crossover is two
+    // Butterworth sections; one bank per section holds its low and high pass for
+    // both channels. Band k also passes through the all-pass of every crossover
+    // above it so that the bands sum flat; all-pass round r runs for every band
+    // that still needs one, one lane per band and channel.
+    std::array<BiquadBank<4>, maxBands - 1> crossoverSection1;
+    std::array<BiquadBank<4>, maxBands - 1> crossoverSection2;
+    std::array<BiquadBank<2 * (maxBands - 2)>, maxBands - 2> crossoverAllpass;
+    int numBands = 0;
+
+    // What the band jobs of the current sub-block work with: the global dephasing
+    // and damping, each band's scale of them, and the block length
+    ParameterRamp::Block blockDephase;
+    ParameterRamp::Block blockDamp;
+    std::array<float, maxBands> bandDephaseScale {};
+    std::array<float, maxBands> bandDampScale {};
+    int bandJobNumSamples = 0;
+
+    // Spreads the bands of large blocks over a few threads. One pool serves every
+    // instance in the process and is only held while Multiband and Parallel Bands
+    // are on, so other instances start no threads. It is taken from prepareToPlay or,
+    // when the settings change during playback, from the message thread, and only
+    // let go while the audio thread is stopped. Null on single-core machines.
+    struct SharedBandWorkers;
+    class BandWorkersUpdater;
+
+    void acquireBandWorkersIfNeeded();
+    void releaseBandWorkers();
+    bool needsBandWorkers() const;
+
+    std::unique_ptr<juce::SharedResourcePointer<SharedBandWorkers>> sharedBandWorkers;
+    std::atomic<RealtimeWorkerPool*> bandWorkers { nullptr };
+    juce::CriticalSection bandWorkersLock;
+    std::unique_ptr<BandWorkersUpdater> bandWorkersUpdater;
+
+    // Counter-based noise for dephasing, one stream per quantum state
+    QuantumNoise dephaseNoiseA;
+    QuantumNoise dephaseNoiseB;
+    std::array<QuantumNoise, 2 * maxBands> bandNoise;
+    juce::uint64 noisePosition = 0;
+
+    // Kernels for the best instruction set of this CPU, or the precise ones at
+    // render quality; both are chosen in prepareToPlay
+    const QuantumKernels::KernelTable* quantumKernels = nullptr;
+    bool renderQuality = false;
+
+    void allocateScratch(int blockSize);
+
+    // Prepares the oversamplers and delays for the OVERSAMPLING settings and the
+    // quality tier, and reports their latency to the host
+    void setupOversampling();
+
+    // The latency the current OVERSAMPLING and QUALITY settings will have once prepared
+    int getLatencyForSettings() const;
+
+    // Copies the input of the current host block, delayed by the latency, from
+    // blockStart on into dest at destStart
+    template <typename SampleType>
+    void readDelayedInput(juce::AudioBuffer<SampleType>& dest, int destStart, int blockStart, int numSamples) noexcept;
+
+    void clearDelays() noexcept;
+
+    const float* getParameterValue(const juce::String& parameterID) const;
+
+    // Drops queued changes and re-reads every parameter
+    void syncParameterValues();
+
+    // Both processBlock overloads; the host's samples are read and written in their
+    // own precision, while the channel and filters keep their internal formats.
+    // processSamples measures the block for the telemetry around processHostBlock.
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, bool bypassedByHost);
+
+    template <typename SampleType>
+    void processHostBlock(juce::AudioBuffer<SampleType>& buffer, bool bypassedByHost);
+
+    // Moves parameters, ramps and noise past a block that is not processed: silence,
+    // bypass, or settings that leave the signal unchanged
+    void skipBlock(int numSamples);
+
+    // Clears the filter states and delays and returns true once their tails have died away
+    bool settleFilters();
+
+    // Runs one stretch of the block over which no parameter changes
+    template <typename SampleType>
+    void processSegment(juce::AudioBuffer<SampleType>& buffer, int segmentStart, int numSamples);
+
+    // Runs the channel on one chunk whose signal has been encoded into state.re;
+    // the amounts start at the chunk's first sample. Damping runs in the state's
+    // oversampler, if it is enabled; without damping the oversampler only delays.
+    template <bool Dephase, bool Damp>
+    void applyQuantumChannel(QuantumState& state, QuantumNoise& noise, float* noiseBuffer, Oversampler& oversampler,
+        const ParameterRamp::Block& dephase, const ParameterRamp::Block& damp, int startSample, int numSamples);
+
+    // One instantiation of the processing core per sample type, mode, channel layout
+    // and set of active stages; processBlock picks one from getModeProcessors() for every block
+    template <typename SampleType, int Mode, int NumIns, int NumOuts, bool Dephase, bool Damp, bool AutoGain>
+    void processMode(juce::AudioBuffer<SampleType>& buffer, int blockStart, int numSamples);
+
+    template <typename SampleType>
+    using ModeProcessor = void (LazirkoAudioProcessor::*)(juce::AudioBuffer<SampleType>&, int, int);
+
+    static constexpr size_t numModeProcessors = 5 * 2 * 2 * 2 * 2 * 2;
+
+    template <typename SampleType>
+    static const std::array<ModeProcessor<SampleType>, numModeProcessors>& getModeProcessors() noexcept;
+
+    template <typename SampleType, size_t Index>
+    static constexpr ModeProcessor<SampleType> getModeProcessor();
+
+    template <typename SampleType, size_t... Indices>
+    static constexpr std::array<ModeProcessor<SampleType>, sizeof...(Indices)> makeModeProcessors(std::index_sequence<Indices...>);
+
+    // Multiband works on whole sub-blocks: split, channel per band (possibly in
+    // parallel), sum, then the same dry/wet mix as the other modes
+    template <typename SampleType, int NumIns, int NumOuts, bool Dephase, bool Damp, bool AutoGain>
+    void processMultiband(juce::AudioBuffer<SampleType>& buffer, int blockStart, int numSamples);
+
+    template <int NumIns, bool Dephase, bool Damp>
+    void processBand(int band, int numSamples);
+
+    template <int NumIns, bool Dephase, bool Damp>
+    static void runBandJob(void* processor, int band);
+
+    float* getBandSignal(int channel, int band) const noexcept
+    {
+        return bandSignals + static_cast<size_t>(channel * maxBands + band) * bandStride;
+    }
+
+    // Splits both channels into numBands bands and writes their sum to the filtered dry buffers
+    template <typename SampleType>
+    void splitBands(const SampleType* inL, const SampleType* inR, int numSamples);
+    void setupCrossovers(double sampleRate, int newNumBands);
+
+    // Writes one chunk of the dry signal into the quantum states; T/S also
+    // writes the sustain band of each channel
+    template <int Mode, int NumIns, typename SampleType>
+    void encodeChunk(const SampleType* inL, const SampleType* inR, float* sustainL, float* sustainR, int numSamples);
+
+    // Dry/wet mix of one chunk, reading the dry signal from the buffer. The gain
+    // and mix blocks start at the chunk and are either both constant or both ramps.
+    template <int Mode, int NumIns, int NumOuts, typename SampleType>
+    void mixChunk(juce::AudioBuffer<SampleType>& buffer, const float* wetA, const float* wetB,
+        const float* filteredL, const float* filteredR, const ParameterRamp::Block& gain,
+        const ParameterRamp::Block& mix, int startSample, int numSamples);
 
-    SimpleFilter transientFilterHP_L, transientFilterHP_R;
-    SimpleFilter transientFilterLP_L, transientFilterLP_R;
+    // The mix loops, with Ramp either a per-sample array or a constant
+    template <int Mode, int NumIns, int NumOuts, typename SampleType, typename Ramp>
+    void mixSamples(juce::AudioBuffer<SampleType>& buffer, const float* wetA, const float* wetB,
+        const float* filteredL, const float* filteredR, Ramp gainRamp, Ramp mixRamp,
+        int startSample, int numSamples);
 
-    // Random generator for dephasing
-    juce::Random randomGen;
+    // Advances the gain compensation and mix ramps by one sub-block
+    void getMixRamps(int numSamples, ParameterRamp::Block& gain, ParameterRamp::Block& mix);
 
-    void ensureQuantumStateSize(int numSamples);
+    // With auto-gain: advances the mix ramp as an array, then feeds one chunk of the
+    // signals into and out of the channel to the loudness window while writing the
+    // gain compensation for the chunk
+    ParameterRamp::Block getMixRampValues(int numSamples);
 
-    // Quantum processing with numSamples parameter
-    void applyQuantumChannel(std::vector<Complex>& state,
-        float dephase, float damp, int numSamples);
+    template <int NumSignals>
+    void followLoudness(const float* const* inputs, const float* const* outputs, int startSample, int numSamples);
 
-    void processMonoMode(juce::AudioBuffer<float>& buffer, int numSamples);
-    void processLeftRightMode(juce::AudioBuffer<float>& buffer, int numSamples);
-    void processMidSideMode(juce::AudioBuffer<float>& buffer, int numSamples);
-    void processTransientSustainMode(juce::AudioBuffer<float>& buffer, int numSamples);
+    // Low-passes one chunk of each channel into the sustain band
+    template <typename SampleType>
+    void splitSustain(const SampleType* inL, const SampleType* inR, float* sustainL, float* sustainR, int numSamples);
 
-    float calculateRMS(const float* data, int numSamples);
     void setupFilters(double sampleRate, float cutoffFreq);
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
@@ -0,0 +1,382 @@
+#include "QuantumKernelsSIMD.h"
+
+#include <JuceHeader.h>
+
+#if LAZIRKO_HAS_SSE2_KERNELS
+ #include <emmintrin.h>
+#endif
+
+#if LAZIRKO_HAS_NEON_KERNELS
+ #include <arm_neon.h>
+#endif
+
+namespace QuantumKernels
+{
+
+namespace
+{
+    struct ScalarOps
+    {
+        using Vec = float;
+        static constexpr int width = 1;
+
+        static Vec load(const float* p)        { return *p; }
+        static void store(float* p, Vec v)     { *p = v; }
+        static Vec set1(float v)               { return v; }
+        static Vec add(Vec a, Vec b)           { return a + b; }
+        static Vec sub(Vec a, Vec b)           { return a - b; }
+        static Vec mul(Vec a, Vec b)           { return a * b; }
+        static Vec reciprocal(Vec a)           { return 1.0f / a; }
+        static Vec mulAdd(Vec a, Vec b, Vec c) { return a * b + c; }
+        static Vec sqrt(Vec a)                 { return std::sqrt(a); }
+        static Vec abs(Vec a)                  { return std::abs(a); }
+        static Vec copySign(Vec a, Vec b)      { return std::copysign(a, b); }
+
+        // Masks are 1.0f / 0.0f for a single lane
+        static Vec greater(Vec a, Vec b)       { return a > b ? 1.0f : 0.0f; }
+        static Vec select(Vec mask, Vec a, Vec b) { return mask != 0.0f ? a : b; }
+    };
+}
+
+void dephaseScalar(float* re, float* im, const float* noise, int numSamples, float dephase)
+{
+    detail::dephase<ScalarOps>(re, im, noise, numSamples, dephase);
+}
+
+void dampScalar(float* re, float* im, int numSamples, float damp)
+{
+    detail::damp<ScalarOps>(re, im, numSamples, damp);
+}
+
+void dephaseRampScalar(float* re, float* im, const float* noise, int numSamples, const float* dephase)
+{
+    detail::dephaseRamp<ScalarOps>(re, im, noise, numSamples, dephase);
+}
+
+void dampRampScalar(float* re, float* im, int numSamples, const float* damp)
+{
+    detail::dampRamp<ScalarOps>(re, im, numSamples, damp);
+}
+
+void dampRealScalar(float* samples, int numSamples, float damp)
+{
+    detail::dampReal<ScalarOps>(samples, numSamples, damp);
+}
+
+void dampRealRampScalar(float* samples, int numSamples, const float* damp)
+{
+    detail::dampRealRamp<ScalarOps>(samples, numSamples, damp);
+}
+
+void fillNoiseScalar(float* dest, uint64_t firstGroup, int numGroups, const NoiseKey& key)
+{
+    for (int g = 0; g < numGroups; ++g)
+    {
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const uint64_t block = (firstGroup + static_cast<uint64_t>(g)) * 4 + static_cast<uint64_t>(lane);
+            uint32_t c0 = static_cast<uint32_t>(block);
+            uint32_t c1 = static_cast<uint32_t>(block >> 32);
+            uint32_t c2 = key.stream;
+            uint32_t c3 = 0;
+            uint32_t k0 = key.key0;
+            uint32_t k1 = key.key1;
+
+            for (int round = 0; round < detail::philoxRounds; ++round)
+            {
+                const uint64_t p0 = static_cast<uint64_t>(detail::philoxM0) * c0;
+                const uint64_t p1 = static_cast<uint64_t>(detail::philoxM1) * c2;
+
+                c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+                c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+                c1 = static_cast<uint32_t>(p1);
+                c3 = static_cast<uint32_t>(p0);
+
+                k0 += detail::philoxW0;
+                k1 += detail::philoxW1;
+            }
+
+            float* group = dest + g * noiseGroupSize + lane;
+            group[0] = static_cast<float>(c0 >> 8) * (1.0f / 16777216.0f);
+            group[4] = static_cast<float>(c1 >> 8) * (1.0f / 16777216.0f);
+            group[8] = static_cast<float>(c2 >> 8) * (1.0f / 16777216.0f);
+            group[12] = static_cast<float>(c3 >> 8) * (1.0f / 16777216.0f);
+        }
+    }
+}
+
+const KernelTable& getScalarKernels()
+{
+    static const KernelTable table { "Scalar", dephaseScalar, dampScalar,
+                                     dephaseRampScalar, dampRampScalar,
+                                     dampRealScalar, dampRealRampScalar, fillNoiseScalar };
+    return table;
+}
+
+//==============================================================================
+#if LAZIRKO_HAS_SSE2_KERNELS
+namespace
+{
+    struct SSE2Ops
+    {
+        using Vec = __m128;
+        using IVec = __m128i;
+        static constexpr int width = 4;
+
+        static Vec load(const float* p)        { return _mm_loadu_ps(p); }
+        static void store(float* p, Vec v)     { _mm_storeu_ps(p, v); }
+        static Vec set1(float v)               { return _mm_set1_ps(v); }
+        static Vec add(Vec a, Vec b)           { return _mm_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b)           { return _mm_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b)           { return _mm_mul_ps(a, b); }
+
+        // rcpps plus one Newton-Raphson step; divps is too slow on older SSE2-only parts
+        static Vec reciprocal(Vec a)
+        {
+            const Vec r = _mm_rcp_ps(a);
+            return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(2.0f), _mm_mul_ps(a, r)));
+        }
+
+        static Vec mulAdd(Vec a, Vec b, Vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static Vec sqrt(Vec a)                 { return _mm_sqrt_ps(a); }
+        static Vec abs(Vec a)                  { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        static Vec greater(Vec a, Vec b)       { return _mm_cmpgt_ps(a, b); }
+
+        static Vec copySign(Vec a, Vec b)
+        {
+            const Vec signMask = _mm_set1_ps(-0.0f);
+            return _mm_or_ps(_mm_andnot_ps(signMask, a), _mm_and_ps(signMask, b));
+        }
+
+        static Vec select(Vec mask, Vec a, Vec b)
+        {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        static IVec loadInt(const uint32_t* p)   { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static IVec set1Int(uint32_t v)          { return _mm_set1_epi32(static_cast<int>(v)); }
+        static IVec bitXor(IVec a, IVec b)       { return _mm_xor_si128(a, b); }
+
+        // pmuludq only multiplies the even lanes, so the odd lanes go through a shifted copy
+        static void mulHiLo(IVec a, uint32_t m, IVec& hi, IVec& lo)
+        {
+            const IVec factor = _mm_set1_epi32(static_cast<int>(m));
+            const IVec even = _mm_mul_epu32(a, factor);
+            const IVec odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), factor);
+            const IVec lowHalves = _mm_set_epi32(0, -1, 0, -1);
+
+            lo = _mm_or_si128(_mm_and_si128(even, lowHalves), _mm_slli_epi64(odd, 32));
+            hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(lowHalves, odd));
+        }
+
+        static Vec toUniform(IVec x)
+        {
+            return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+        }
+
+        static void storeNoiseGroups(float* dest, Vec w0, Vec w1, Vec w2, Vec w3)
+        {
+            _mm_storeu_ps(dest, w0);
+            _mm_storeu_ps(dest + 4, w1);
+            _mm_storeu_ps(dest + 8, w2);
+            _mm_storeu_ps(dest + 12, w3);
+        }
+    };
+
+    const KernelTable sse2Kernels { "SSE2", detail::dephase<SSE2Ops>, detail::damp<SSE2Ops>,
+                                    detail::dephaseRamp<SSE2Ops>, detail::dampRamp<SSE2Ops>,
+                                    detail::dampReal<SSE2Ops>, detail::dampRealRamp<SSE2Ops>,
+                                    detail::fillNoise<SSE2Ops> };
+}
+#endif
+
+#if LAZIRKO_HAS_NEON_KERNELS
+namespace
+{
+    struct NEONOps
+    {
+        using Vec = float32x4_t;
+        using IVec = uint32x4_t;
+        static constexpr int width = 4;
+
+        static Vec load(const float* p)        { return vld1q_f32(p); }
+        static void store(float* p, Vec v)     { vst1q_f32(p, v); }
+        static Vec set1(float v)               { return vdupq_n_f32(v); }
+        static Vec add(Vec a, Vec b)           { return vaddq_f32(a, b); }
+        static Vec sub(Vec a, Vec b)           { return vsubq_f32(a, b); }
+        static Vec mul(Vec a, Vec b)           { return vmulq_f32(a, b); }
+        static Vec reciprocal(Vec a)           { return vdivq_f32(vdupq_n_f32(1.0f), a); }
+        static Vec mulAdd(Vec a, Vec b, Vec c) { return vfmaq_f32(c, a, b); }
+        static Vec sqrt(Vec a)                 { return vsqrtq_f32(a); }
+        static Vec abs(Vec a)                  { return vabsq_f32(a); }
+        static Vec greater(Vec a, Vec b)       { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+
+        static Vec copySign(Vec a, Vec b)
+        {
+            return vbslq_f32(vdupq_n_u32(0x80000000u), b, a);
+        }
+
+        static Vec select(Vec mask, Vec a, Vec b)
+        {
+            return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+        }
+
+        static IVec loadInt(const uint32_t* p)   { return vld1q_u32(p); }
+        static IVec set1Int(uint32_t v)          { return vdupq_n_u32(v); }
+        static IVec bitXor(IVec a, IVec b)       { return veorq_u32(a, b); }
+
+        static void mulHiLo(IVec a, uint32_t m, IVec& hi, IVec& lo)
+        {
+            const uint32x2_t factor = vdup_n_u32(m);
+            const uint64x2_t low = vmull_u32(vget_low_u32(a), factor);
+            const uint64x2_t high = vmull_u32(vget_high_u32(a), factor);
+            const uint32x4x2_t halves = vuzpq_u32(vreinterpretq_u32_u64(low), vreinterpretq_u32_u64(high));
+
+            lo = halves.val[0];
+            hi = halves.val[1];
+        }
+
+        static Vec toUniform(IVec x)
+        {
+            return vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(x, 8)), 1.0f / 16777216.0f);
+        }
+
+        static void storeNoiseGroups(float* dest, Vec w0, Vec w1, Vec w2, Vec w3)
+        {
+            vst1q_f32(dest, w0);
+            vst1q_f32(dest + 4, w1);
+            vst1q_f32(dest + 8, w2);
+            vst1q_f32(dest + 12, w3);
+        }
+    };
+
+    const KernelTable neonKernels { "NEON", detail::dephase<NEONOps>, detail::damp<NEONOps>,
+                                    detail::dephaseRamp<NEONOps>, detail::dampRamp<NEONOps>,
+                                    detail::dampReal<NEONOps>, detail::dampRealRamp<NEONOps>,
+                                    detail::fillNoise<NEONOps> };
+}
+#endif
+
+//==============================================================================
+const KernelTable& selectBestKernels()
+{
+   #if LAZIRKO_HAS_AVX2_KERNELS
+    if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+        return detail::getAVX2Kernels();
+   #endif
+
+   #if LAZIRKO_HAS_SSE2_KERNELS
+    return sse2Kernels;
+   #elif LAZIRKO_HAS_NEON_KERNELS
+    return neonKernels;
+   #else
+    return getScalarKernels();
+   #endif
+}
+
+//==============================================================================
+namespace
+{
+    // The same channel with libm sin/cos and a true division, worked in double and
+    // rounded back to the float state
+    void dephasePreciseStep(float& re, float& im, float noise, double dephaseAmount)
+    {
+        const double r = re;
+        const double i = im;
+        const double mag = std::sqrt(r * r + i * i);
+
+        if (mag <= static_cast<double>(detail::magnitudeThreshold))
+            return;
+
+        const double randPhase = (static_cast<double>(noise) * 2.0 - 1.0) * juce::MathConstants<double>::pi * dephaseAmount;
+        const double s = std::sin(randPhase);
+        const double c = std::cos(randPhase);
+
+        const double incoherence = dephaseAmount * 0.5;
+        const double coherence = 1.0 - incoherence;
+
+        re = static_cast<float>(coherence * (r * c - i * s) + incoherence * mag);
+        im = static_cast<float>(coherence * (r * s + i * c));
+    }
+
+    float dampPreciseStep(float x, double dampAmount)
+    {
+        const double driven = static_cast<double>(x) * (1.0 + 7.0 * dampAmount);
+        return static_cast<float>(driven * (1.0 + 1.5 * dampAmount) / (1.0 + std::abs(driven)));
+    }
+
+    void dephasePrecise(float* re, float* im, const float* noise, int numSamples, float dephase)
+    {
+        for (int n = 0; n < numSamples; ++n)
+            dephasePreciseStep(re[n], im[n], noise[n], dephase);
+    }
+
+    void dampPrecise(float* re, float* im, int numSamples, float damp)
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            re[n] = dampPreciseStep(re[n], damp);
+            im[n] = dampPreciseStep(im[n], damp);
+        }
+    }
+
+    void dephaseRampPrecise(float* re, float* im, const float* noise, int numSamples, const float* dephase)
+    {
+        for (int n = 0; n < numSamples; ++n)
+            dephasePreciseStep(re[n], im[n], noise[n], dephase[n]);
+    }
+
+    void dampRampPrecise(float* re, float* im, int numSamples, const float* damp)
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            re[n] = dampPreciseStep(re[n], damp[n]);
+            im[n] = dampPreciseStep(im[n], damp[n]);
+        }
+    }
+
+    void dampRealPrecise(float* samples, int numSamples, float damp)
+    {
+        for (int n = 0; n < numSamples; ++n)
+            samples[n] = dampPreciseStep(samples[n], damp);
+    }
+
+    void dampRealRampPrecise(float* samples, int numSamples, const float* damp)
+    {
+        for (int n = 0; n < numSamples; ++n)
+            samples[n] = dampPreciseStep(samples[n], damp[n]);
+    }
+}
+
+const KernelTable& getPreciseKernels()
+{
+    // The noise is the same on every instruction set, so it comes from the fastest
+    static const KernelTable table { "Precise", dephasePrecise, dampPrecise,
+                                     dephaseRampPrecise, dampRampPrecise,
+                                     dampRealPrecise, dampRealRampPrecise,
+                                     selectBestKernels().fillNoise };
+    return table;
+}
+
+std::vector<const KernelTable*> getAllKernels()
+{
+    std::vector<const KernelTable*> tables { &getScalarKernels() };
+
+   #if LAZIRKO_HAS_SSE2_KERNELS
+    tables.push_back(&sse2Kernels);
+   #endif
+
+   #if LAZIRKO_HAS_AVX2_KERNELS
+    if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+        tables.push_back(&detail::getAVX2Kernels());
+   #endif
+
+   #if LAZIRKO_HAS_NEON_KERNELS
+    tables.push_back(&neonKernels);
+   #endif
+
+    tables.push_back(&getPreciseKernels());
+    return tables;
+}
+
+}
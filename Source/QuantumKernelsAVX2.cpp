@@ -0,0 +1,96 @@
+#include "QuantumKernels.h"
+
+#if LAZIRKO_HAS_AVX2_KERNELS
+
+// Everything that is not part of the kernels must be included before the target
+// pragma, so that none of those inline functions get compiled with AVX2 enabled.
+#include <cmath>
+#include <immintrin.h>
+
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("avx2,fma")
+#endif
+
+#include "QuantumKernelsSIMD.h"
+
+namespace
+{
+    struct AVX2Ops
+    {
+        using Vec = __m256;
+        using IVec = __m256i;
+        static constexpr int width = 8;
+
+        static Vec load(const float* p)        { return _mm256_loadu_ps(p); }
+        static void store(float* p, Vec v)     { _mm256_storeu_ps(p, v); }
+        static Vec set1(float v)               { return _mm256_set1_ps(v); }
+        static Vec add(Vec a, Vec b)           { return _mm256_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b)           { return _mm256_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b)           { return _mm256_mul_ps(a, b); }
+        static Vec reciprocal(Vec a)           { return _mm256_div_ps(_mm256_set1_ps(1.0f), a); }
+        static Vec mulAdd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+        static Vec sqrt(Vec a)                 { return _mm256_sqrt_ps(a); }
+        static Vec abs(Vec a)                  { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        static Vec greater(Vec a, Vec b)       { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static Vec select(Vec mask, Vec a, Vec b) { return _mm256_blendv_ps(b, a, mask); }
+
+        static Vec copySign(Vec a, Vec b)
+        {
+            const Vec signMask = _mm256_set1_ps(-0.0f);
+            return _mm256_or_ps(_mm256_andnot_ps(signMask, a), _mm256_and_ps(signMask, b));
+        }
+
+        static IVec loadInt(const uint32_t* p)   { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static IVec set1Int(uint32_t v)          { return _mm256_set1_epi32(static_cast<int>(v)); }
+        static IVec bitXor(IVec a, IVec b)       { return _mm256_xor_si256(a, b); }
+
+        static void mulHiLo(IVec a, uint32_t m, IVec& hi, IVec& lo)
+        {
+            const IVec factor = _mm256_set1_epi32(static_cast<int>(m));
+            const IVec even = _mm256_mul_epu32(a, factor);
+            const IVec odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), factor);
+
+            lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+            hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+        }
+
+        static Vec toUniform(IVec x)
+        {
+            return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(x, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+        }
+
+        // The low and high 128-bit halves hold two consecutive noise groups
+        static void storeNoiseGroups(float* dest, Vec w0, Vec w1, Vec w2, Vec w3)
+        {
+            _mm256_storeu_ps(dest, _mm256_permute2f128_ps(w0, w1, 0x20));
+            _mm256_storeu_ps(dest + 8, _mm256_permute2f128_ps(w2, w3, 0x20));
+            _mm256_storeu_ps(dest + 16, _mm256_permute2f128_ps(w0, w1, 0x31));
+            _mm256_storeu_ps(dest + 24, _mm256_permute2f128_ps(w2, w3, 0x31));
+        }
+    };
+}
+
+namespace QuantumKernels
+{
+namespace detail
+{
+    const KernelTable& getAVX2Kernels()
+    {
+        static const KernelTable table { "AVX2", dephase<AVX2Ops>, damp<AVX2Ops>,
+                                         dephaseRamp<AVX2Ops>, dampRamp<AVX2Ops>,
+                                         dampReal<AVX2Ops>, dampRealRamp<AVX2Ops>, fillNoise<AVX2Ops> };
+        return table;
+    }
+}
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+#endif
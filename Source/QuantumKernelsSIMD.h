@@ -0,0 +1,340 @@
+#pragma once
+
+#include "QuantumKernels.h"
+
+#include <cmath>
+
+/*
+    Instruction-set independent bodies of the quantum channel kernels.
+
+    Each instruction set provides an "Ops" struct wrapping its vector type
+    (load/store, arithmetic, compares and a blend), and instantiates the templates
+    below with it. The portable scalar kernels are the same templates instantiated
+    with a one-lane ScalarOps. The vector versions run the last few samples of a
+    block as one zero-padded vector rather than through the scalar kernels, so a
+    sample gets the same arithmetic wherever a block boundary happens to fall and
+    the output does not depend on the host's block size. The Ops structs live in
+    anonymous namespaces, so every instantiation has internal linkage and can
+    safely be compiled with different target flags in different translation units.
+*/
+
+namespace QuantumKernels
+{
+namespace detail
+{
+    constexpr float pi = 3.14159265358979323846f;
+    constexpr float halfPi = 1.57079632679489661923f;
+    constexpr float magnitudeThreshold = 1e-12f;
+
+    // Philox4x32 multipliers and Weyl key increments (Salmon et al., Random123)
+    constexpr uint32_t philoxM0 = 0xD2511F53u;
+    constexpr uint32_t philoxM1 = 0xCD9E8D57u;
+    constexpr uint32_t philoxW0 = 0x9E3779B9u;
+    constexpr uint32_t philoxW1 = 0xBB67AE85u;
+    constexpr int philoxRounds = 10;
+
+   #if LAZIRKO_HAS_AVX2_KERNELS
+    const KernelTable& getAVX2Kernels();
+   #endif
+
+    //==============================================================================
+    /** sin and cos of an angle in [-pi, pi]: fold to [-pi/2, pi/2], then evaluate
+        Taylor polynomials (max error below 1e-6). */
+    template <typename Ops>
+    void sinCosApprox(typename Ops::Vec x, typename Ops::Vec& sinOut, typename Ops::Vec& cosOut)
+    {
+        using V = typename Ops::Vec;
+
+        const V folded = Ops::greater(Ops::abs(x), Ops::set1(halfPi));
+        const V r = Ops::select(folded, Ops::sub(Ops::copySign(Ops::set1(pi), x), x), x);
+        const V r2 = Ops::mul(r, r);
+
+        V s = Ops::set1(-2.5052108e-8f);
+        s = Ops::mulAdd(s, r2, Ops::set1(2.7557319e-6f));
+        s = Ops::mulAdd(s, r2, Ops::set1(-1.9841270e-4f));
+        s = Ops::mulAdd(s, r2, Ops::set1(8.3333333e-3f));
+        s = Ops::mulAdd(s, r2, Ops::set1(-1.6666667e-1f));
+        s = Ops::mulAdd(Ops::mul(s, r2), r, r);
+
+        V c = Ops::set1(-2.7557319e-7f);
+        c = Ops::mulAdd(c, r2, Ops::set1(2.4801587e-5f));
+        c = Ops::mulAdd(c, r2, Ops::set1(-1.3888889e-3f));
+        c = Ops::mulAdd(c, r2, Ops::set1(4.1666667e-2f));
+        c = Ops::mulAdd(c, r2, Ops::set1(-0.5f));
+        c = Ops::mulAdd(c, r2, Ops::set1(1.0f));
+
+        sinOut = s;
+        cosOut = Ops::select(folded, Ops::sub(Ops::set1(0.0f), c), c);
+    }
+
+    //==============================================================================
+    /** The last numSamples < Ops::width samples of a block, copied into zero-padded
+        vectors for one more step of the vector code. Zeros pass every stage. */
+    template <typename Ops, int NumArrays>
+    struct Tail
+    {
+        explicit Tail(int count) noexcept : numSamples(count) {}
+
+        // Plain loops rather than memcpy: this header is compiled under AVX2 target
+        // pragmas, where no other header may be included
+        float* in(int index, const float* source) noexcept
+        {
+            for (int n = 0; n < numSamples; ++n)
+                data[index][n] = source[n];
+
+            return data[index];
+        }
+
+        void out(int index, float* dest) const noexcept
+        {
+            for (int n = 0; n < numSamples; ++n)
+                dest[n] = data[index][n];
+        }
+
+        alignas(32) float data[NumArrays][Ops::width] = {};
+        const int numSamples;
+    };
+
+    //==============================================================================
+    /** Rotating by a random angle is a complex multiply by the unit phasor
+        (cos r, sin r), so no atan2 or polar round trip is needed. Processes
+        Ops::width samples with one dephase amount per lane. */
+    template <typename Ops>
+    inline void dephaseStep(float* re, float* im, const float* noise, typename Ops::Vec dephaseAmount)
+    {
+        using V = typename Ops::Vec;
+
+        const V maxPhaseShift = Ops::mul(Ops::set1(pi), dephaseAmount);
+        const V incoherence = Ops::mul(dephaseAmount, Ops::set1(0.5f));
+        const V coherence = Ops::sub(Ops::set1(1.0f), incoherence);
+
+        const V r = Ops::load(re);
+        const V i = Ops::load(im);
+        const V mag = Ops::sqrt(Ops::mulAdd(r, r, Ops::mul(i, i)));
+
+        // Random phase shift as a unit phasor
+        const V randPhase = Ops::mul(Ops::sub(Ops::mul(Ops::load(noise), Ops::set1(2.0f)), Ops::set1(1.0f)), maxPhaseShift);
+        V s, c;
+        sinCosApprox<Ops>(randPhase, s, c);
+
+        // Rotate, then mix toward magnitude-only for coherence loss
+        const V rotRe = Ops::sub(Ops::mul(r, c), Ops::mul(i, s));
+        const V rotIm = Ops::mulAdd(r, s, Ops::mul(i, c));
+        const V newRe = Ops::mulAdd(coherence, rotRe, Ops::mul(incoherence, mag));
+        const V newIm = Ops::mul(coherence, rotIm);
+
+        const V active = Ops::greater(mag, Ops::set1(magnitudeThreshold));
+        Ops::store(re, Ops::select(active, newRe, r));
+        Ops::store(im, Ops::select(active, newIm, i));
+    }
+
+    template <typename Ops>
+    void dephase(float* re, float* im, const float* noise, int numSamples, float dephaseAmount)
+    {
+        const auto amount = Ops::set1(dephaseAmount);
+
+        int n = 0;
+        for (; n + Ops::width <= numSamples; n += Ops::width)
+            dephaseStep<Ops>(re + n, im + n, noise + n, amount);
+
+        if constexpr (Ops::width > 1)
+            if (n < numSamples)
+            {
+                Tail<Ops, 3> tail(numSamples - n);
+                dephaseStep<Ops>(tail.in(0, re + n), tail.in(1, im + n), tail.in(2, noise + n), amount);
+                tail.out(0, re + n);
+                tail.out(1, im + n);
+            }
+    }
+
+    template <typename Ops>
+    void dephaseRamp(float* re, float* im, const float* noise, int numSamples, const float* dephaseAmounts)
+    {
+        int n = 0;
+        for (; n + Ops::width <= numSamples; n += Ops::width)
+            dephaseStep<Ops>(re + n, im + n, noise + n, Ops::load(dephaseAmounts + n));
+
+        if constexpr (Ops::width > 1)
+            if (n < numSamples)
+            {
+                Tail<Ops, 4> tail(numSamples - n);
+                dephaseStep<Ops>(tail.in(0, re + n), tail.in(1, im + n), tail.in(2, noise + n),
+                                 Ops::load(tail.in(3, dephaseAmounts + n)));
+                tail.out(0, re + n);
+                tail.out(1, im + n);
+            }
+    }
+
+    /** x * drive into x / (1 + |x|), times the makeup gain. */
+    template <typename Ops>
+    inline typename Ops::Vec softClip(typename Ops::Vec x, typename Ops::Vec drive, typename Ops::Vec makeup)
+    {
+        const auto driven = Ops::mul(x, drive);
+        return Ops::mul(Ops::mul(driven, makeup), Ops::reciprocal(Ops::add(Ops::set1(1.0f), Ops::abs(driven))));
+    }
+
+    /** Soft saturation of Ops::width samples, one damp amount per lane. */
+    template <typename Ops>
+    inline void dampStep(float* re, float* im, typename Ops::Vec dampAmount)
+    {
+        using V = typename Ops::Vec;
+
+        const V one = Ops::set1(1.0f);
+        const V drive = Ops::add(one, Ops::mul(Ops::set1(7.0f), dampAmount));
+        const V makeup = Ops::add(one, Ops::mul(Ops::set1(1.5f), dampAmount));
+
+        Ops::store(re, softClip<Ops>(Ops::load(re), drive, makeup));
+        Ops::store(im, softClip<Ops>(Ops::load(im), drive, makeup));
+    }
+
+    /** The same saturation of the real part alone. */
+    template <typename Ops>
+    inline void dampRealStep(float* samples, typename Ops::Vec dampAmount)
+    {
+        using V = typename Ops::Vec;
+
+        const V one = Ops::set1(1.0f);
+        const V drive = Ops::add(one, Ops::mul(Ops::set1(7.0f), dampAmount));
+        const V makeup = Ops::add(one, Ops::mul(Ops::set1(1.5f), dampAmount));
+
+        Ops::store(samples, softClip<Ops>(Ops::load(samples), drive, makeup));
+    }
+
+    template <typename Ops>
+    void damp(float* re, float* im, int numSamples, float dampAmount)
+    {
+        const auto amount = Ops::set1(dampAmount);
+
+        int n = 0;
+        for (; n + Ops::width <= numSamples; n += Ops::width)
+            dampStep<Ops>(re + n, im + n, amount);
+
+        if constexpr (Ops::width > 1)
+            if (n < numSamples)
+            {
+                Tail<Ops, 2> tail(numSamples - n);
+                dampStep<Ops>(tail.in(0, re + n), tail.in(1, im + n), amount);
+                tail.out(0, re + n);
+                tail.out(1, im + n);
+            }
+    }
+
+    template <typename Ops>
+    void dampRamp(float* re, float* im, int numSamples, const float* dampAmounts)
+    {
+        int n = 0;
+        for (; n + Ops::width <= numSamples; n += Ops::width)
+            dampStep<Ops>(re + n, im + n, Ops::load(dampAmounts + n));
+
+        if constexpr (Ops::width > 1)
+            if (n < numSamples)
+            {
+                Tail<Ops, 3> tail(numSamples - n);
+                dampStep<Ops>(tail.in(0, re + n), tail.in(1, im + n), Ops::load(tail.in(2, dampAmounts + n)));
+                tail.out(0, re + n);
+                tail.out(1, im + n);
+            }
+    }
+
+    template <typename Ops>
+    void dampReal(float* samples, int numSamples, float dampAmount)
+    {
+        const auto amount = Ops::set1(dampAmount);
+
+        int n = 0;
+        for (; n + Ops::width <= numSamples; n += Ops::width)
+            dampRealStep<Ops>(samples + n, amount);
+
+        if constexpr (Ops::width > 1)
+            if (n < numSamples)
+            {
+                Tail<Ops, 1> tail(numSamples - n);
+                dampRealStep<Ops>(tail.in(0, samples + n), amount);
+                tail.out(0, samples + n);
+            }
+    }
+
+    template <typename Ops>
+    void dampRealRamp(float* samples, int numSamples, const float* dampAmounts)
+    {
+        int n = 0;
+        for (; n + Ops::width <= numSamples; n += Ops::width)
+            dampRealStep<Ops>(samples + n, Ops::load(dampAmounts + n));
+
+        if constexpr (Ops::width > 1)
+            if (n < numSamples)
+            {
+                Tail<Ops, 2> tail(numSamples - n);
+                dampRealStep<Ops>(tail.in(0, samples + n), Ops::load(tail.in(1, dampAmounts + n)));
+                tail.out(0, samples + n);
+            }
+    }
+
+    /** Runs Philox4x32-10 on one block counter per lane. Each vector of lanes covers
+        Ops::width / 4 whole noise groups, so the result is independent of the width.
+        Two vectors are kept in flight because every round is a serial multiply chain. */
+    template <typename Ops>
+    void fillNoise(float* dest, uint64_t firstGroup, int numGroups, const NoiseKey& key)
+    {
+        using IV = typename Ops::IVec;
+
+        constexpr int lanes = 2 * Ops::width;
+        constexpr int groupsPerStep = lanes / 4;
+
+        int g = 0;
+        for (; g + groupsPerStep <= numGroups; g += groupsPerStep)
+        {
+            alignas(32) uint32_t counterLo[lanes];
+            alignas(32) uint32_t counterHi[lanes];
+
+            const uint64_t firstBlock = (firstGroup + static_cast<uint64_t>(g)) * 4;
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                counterLo[lane] = static_cast<uint32_t>(firstBlock + static_cast<uint64_t>(lane));
+                counterHi[lane] = static_cast<uint32_t>((firstBlock + static_cast<uint64_t>(lane)) >> 32);
+            }
+
+            IV a0 = Ops::loadInt(counterLo), b0 = Ops::loadInt(counterLo + Ops::width);
+            IV a1 = Ops::loadInt(counterHi), b1 = Ops::loadInt(counterHi + Ops::width);
+            IV a2 = Ops::set1Int(key.stream), b2 = a2;
+            IV a3 = Ops::set1Int(0), b3 = a3;
+            uint32_t k0 = key.key0;
+            uint32_t k1 = key.key1;
+
+            for (int round = 0; round < philoxRounds; ++round)
+            {
+                IV aHi0, aLo0, aHi1, aLo1, bHi0, bLo0, bHi1, bLo1;
+                Ops::mulHiLo(a0, philoxM0, aHi0, aLo0);
+                Ops::mulHiLo(a2, philoxM1, aHi1, aLo1);
+                Ops::mulHiLo(b0, philoxM0, bHi0, bLo0);
+                Ops::mulHiLo(b2, philoxM1, bHi1, bLo1);
+
+                const IV roundKey0 = Ops::set1Int(k0);
+                const IV roundKey1 = Ops::set1Int(k1);
+
+                a0 = Ops::bitXor(Ops::bitXor(aHi1, a1), roundKey0);
+                a2 = Ops::bitXor(Ops::bitXor(aHi0, a3), roundKey1);
+                a1 = aLo1;
+                a3 = aLo0;
+
+                b0 = Ops::bitXor(Ops::bitXor(bHi1, b1), roundKey0);
+                b2 = Ops::bitXor(Ops::bitXor(bHi0, b3), roundKey1);
+                b1 = bLo1;
+                b3 = bLo0;
+
+                k0 += philoxW0;
+                k1 += philoxW1;
+            }
+
+            float* out = dest + g * noiseGroupSize;
+            Ops::storeNoiseGroups(out, Ops::toUniform(a0), Ops::toUniform(a1),
+                                  Ops::toUniform(a2), Ops::toUniform(a3));
+            Ops::storeNoiseGroups(out + Ops::width * 4, Ops::toUniform(b0), Ops::toUniform(b1),
+                                  Ops::toUniform(b2), Ops::toUniform(b3));
+        }
+
+        if (g < numGroups)
+            fillNoiseScalar(dest + g * noiseGroupSize, firstGroup + static_cast<uint64_t>(g), numGroups - g, key);
+    }
+}
+}
@@ -0,0 +1,59 @@
+#include "QuantumNoise.h"
+
+#include <cstring>
+
+QuantumNoise::QuantumNoise()
+    : kernels(&QuantumKernels::selectBestKernels())
+{
+}
+
+void QuantumNoise::setSeed(juce::uint64 newSeed) noexcept
+{
+    key.key0 = static_cast<juce::uint32>(newSeed);
+    key.key1 = static_cast<juce::uint32>(newSeed >> 32);
+}
+
+void QuantumNoise::setStream(juce::uint32 newStream) noexcept
+{
+    key.stream = newStream;
+}
+
+void QuantumNoise::fill(float* dest, int numSamples) noexcept
+{
+    constexpr int groupSize = QuantumKernels::noiseGroupSize;
+
+    // Head: finish the group the current position falls into
+    const int offset = static_cast<int>(position % groupSize);
+    if (offset != 0 && numSamples > 0)
+    {
+        const int count = juce::jmin(groupSize - offset, numSamples);
+        fillPartialGroup(dest, position / groupSize, offset, count);
+        dest += count;
+        numSamples -= count;
+        position += static_cast<juce::uint64>(count);
+    }
+
+    // Whole groups straight into the destination
+    const int numGroups = numSamples / groupSize;
+    if (numGroups > 0)
+    {
+        kernels->fillNoise(dest, position / groupSize, numGroups, key);
+        dest += numGroups * groupSize;
+        numSamples -= numGroups * groupSize;
+        position += static_cast<juce::uint64>(numGroups * groupSize);
+    }
+
+    // Tail
+    if (numSamples > 0)
+    {
+        fillPartialGroup(dest, position / groupSize, 0, numSamples);
+        position += static_cast<juce::uint64>(numSamples);
+    }
+}
+
+void QuantumNoise::fillPartialGroup(float* dest, juce::uint64 group, int offset, int numSamples) noexcept
+{
+    float scratch[QuantumKernels::noiseGroupSize];
+    kernels->fillNoise(scratch, group, 1, key);
+    std::memcpy(dest, scratch + offset, sizeof(float) * static_cast<size_t>(numSamples));
+}
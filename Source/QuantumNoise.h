@@ -0,0 +1,43 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "QuantumKernels.h"
+
+/*
+    Seekable uniform noise for the dephasing stage.
+
+    Sample i of a stream is a pure function of (seed, stream, i): it comes from a
+    Philox4x32-10 counter-based generator, so a whole block is produced in one
+    vectorised pass and any position can be reached in O(1). A chunked or
+    multi-threaded render that seeks each chunk to its start sample therefore
+    reproduces the noise of a serial render exactly.
+*/
+class QuantumNoise
+{
+public:
+    QuantumNoise();
+
+    /** Selects the noise sequence; the position is left unchanged. */
+    void setSeed(juce::uint64 newSeed) noexcept;
+
+    /** Independent sub-streams of the same seed, e.g. one per channel. */
+    void setStream(juce::uint32 newStream) noexcept;
+
+    /** Jumps to an absolute sample position in the stream. */
+    void seek(juce::uint64 newPosition) noexcept  { position = newPosition; }
+
+    juce::uint64 getPosition() const noexcept     { return position; }
+
+    /** Writes numSamples uniform floats in [0, 1) and advances the position. */
+    void fill(float* dest, int numSamples) noexcept;
+
+private:
+    const QuantumKernels::KernelTable* kernels = nullptr;
+    QuantumKernels::NoiseKey key;
+    juce::uint64 position = 0;
+
+    void fillPartialGroup(float* dest, juce::uint64 group, int offset, int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(QuantumNoise)
+};
@@ -0,0 +1,136 @@
+#include "RealtimeWorkerPool.h"
+
+#include <thread>
+
+namespace
+{
+    std::uint32_t batchOf(std::uint64_t ticket) noexcept    { return static_cast<std::uint32_t>(ticket >> 32); }
+    int jobCountOf(std::uint64_t ticket) noexcept           { return static_cast<int>((ticket >> 16) & 0xffff); }
+    int jobIndexOf(std::uint64_t ticket) noexcept           { return static_cast<int>(ticket & 0xffff); }
+}
+
+class RealtimeWorkerPool::Worker : public juce::Thread
+{
+public:
+    Worker(RealtimeWorkerPool& ownerPool, int index)
+        : juce::Thread("Lazirko worker " + juce::String(index)), pool(ownerPool)
+    {
+        if (! startRealtimeThread(juce::Thread::RealtimeOptions().withPriority(8)))
+            startThread(juce::Thread::Priority::high);
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(2000);
+    }
+
+    void run() override
+    {
+        std::uint32_t lastBatch = 0;
+
+        while (! threadShouldExit())
+        {
+            if (! waitForNextBatch(lastBatch))
+                continue;
+
+            lastBatch = batchOf(pool.ticket.load(std::memory_order_acquire));
+            pool.runJobs(lastBatch);
+        }
+    }
+
+    juce::WaitableEvent wakeUp;
+    std::atomic<bool> sleeping { false };
+
+private:
+    RealtimeWorkerPool& pool;
+
+    // Hosts call back every few milliseconds, so a short spin catches most blocks
+    // without a wake-up; after that the worker sleeps until run() signals it
+    static constexpr int spinCount = 200;
+
+    bool waitForNextBatch(std::uint32_t lastBatch)
+    {
+        for (int spin = 0; spin < spinCount; ++spin)
+        {
+            if (batchOf(pool.ticket.load(std::memory_order_acquire)) != lastBatch)
+                return true;
+
+            std::this_thread::yield();
+        }
+
+        // run() publishes the ticket before it looks at this flag, and the flag is
+        // set before the ticket is checked again, so no batch is missed
+        sleeping.store(true);
+
+        if (batchOf(pool.ticket.load()) == lastBatch && ! threadShouldExit())
+            wakeUp.wait(100);
+
+        sleeping.store(false);
+        return batchOf(pool.ticket.load(std::memory_order_acquire)) != lastBatch;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+};
+
+//==============================================================================
+RealtimeWorkerPool::RealtimeWorkerPool(int numWorkers)
+{
+    for (int i = 0; i < numWorkers; ++i)
+        workers.add(new Worker(*this, i + 1));
+}
+
+RealtimeWorkerPool::~RealtimeWorkerPool()
+{
+    workers.clear();
+}
+
+bool RealtimeWorkerPool::run(Job job, void* context, int numJobs) noexcept
+{
+    jassert(numJobs < 0x10000);
+
+    if (numJobs <= 0)
+        return true;
+
+    // Another processor's batch has the workers
+    if (busy.exchange(true, std::memory_order_acquire))
+        return false;
+
+    currentJob = job;
+    currentContext = context;
+    jobsRemaining.store(numJobs, std::memory_order_relaxed);
+
+    const std::uint32_t batch = ++generation;
+    ticket.store((static_cast<std::uint64_t>(batch) << 32) | (static_cast<std::uint64_t>(numJobs) << 16));
+
+    for (auto* worker : workers)
+        if (worker->sleeping.load())
+            worker->wakeUp.signal();
+
+    runJobs(batch);
+
+    // Every job has been claimed; wait for the ones still running on workers
+    while (jobsRemaining.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+
+    busy.store(false, std::memory_order_release);
+    return true;
+}
+
+void RealtimeWorkerPool::runJobs(std::uint32_t batch) noexcept
+{
+    for (;;)
+    {
+        auto current = ticket.load(std::memory_order_acquire);
+
+        if (batchOf(current) != batch || jobIndexOf(current) >= jobCountOf(current))
+            return;
+
+        if (! ticket.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+            continue;
+
+        currentJob(currentContext, jobIndexOf(current));
+        jobsRemaining.fetch_sub(1, std::memory_order_release);
+    }
+}
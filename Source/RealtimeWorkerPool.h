@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <cstdint>
+
+/*
+    A few worker threads that help the audio thread through one batch of
+    independent jobs, such as the bands of a multiband block.
+
+    run() hands out job indices through a single atomic ticket; the calling thread
+    takes jobs too and returns once every job has finished, so a worker that is
+    slow to wake only costs parallelism, never correctness. run() takes no locks
+    and does not allocate. Between batches the workers spin briefly and then sleep
+    on an event, which run() only signals when a worker is actually asleep.
+
+    Several processors can share one pool, each from its own audio thread: a batch
+    runs for one caller at a time, and run() returns false straight away, without
+    running anything, while another caller's batch is under way.
+*/
+class RealtimeWorkerPool
+{
+public:
+    using Job = void (*)(void* context, int jobIndex);
+
+    explicit RealtimeWorkerPool(int numWorkers);
+    ~RealtimeWorkerPool();
+
+    int getNumWorkers() const noexcept  { return workers.size(); }
+
+    /** Calls job(context, i) for every i in [0, numJobs) and waits for all of them.
+        Returns false, having called nothing, if the pool is busy with another batch;
+        the caller then has to do the jobs itself. */
+    bool run(Job job, void* context, int numJobs) noexcept;
+
+private:
+    class Worker;
+
+    juce::OwnedArray<Worker> workers;
+
+    // Generation in the top 32 bits, job count and next job index below it, so a
+    // worker still finishing one batch can never claim a job of the next one
+    std::atomic<std::uint64_t> ticket { 0 };
+    std::atomic<int> jobsRemaining { 0 };
+    std::atomic<bool> busy { false };
+    Job currentJob = nullptr;
+    void* currentContext = nullptr;
+    std::uint32_t generation = 0;
+
+    void runJobs(std::uint32_t batch) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeWorkerPool)
+};
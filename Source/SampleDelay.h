@@ -0,0 +1,92 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <cmath>
+#include <cstring>
+
+/*
+    A delay of a whole number of samples on one signal, as a ring buffer.
+
+    The ring holds the delay plus one block, so a block can be written whole and
+    then read back from any point up to one ring length in the past. Blocks are
+    copied in at most two pieces each; nothing is done per sample.
+*/
+template <typename SampleType>
+class SampleDelay
+{
+public:
+    /** Allocates for the delay plus blocks of up to maxBlockSize, and clears. */
+    void prepare(int delaySamples, int maxBlockSize)
+    {
+        delay = juce::jmax(0, delaySamples);
+        capacity = juce::nextPowerOfTwo(delay + juce::jmax(1, maxBlockSize));
+        buffer.allocate(static_cast<size_t>(capacity), true);
+        writePosition = 0;
+    }
+
+    void reset() noexcept
+    {
+        if (capacity > 0)
+            std::memset(buffer.get(), 0, sizeof(SampleType) * static_cast<size_t>(capacity));
+
+        writePosition = 0;
+    }
+
+    int getDelay() const noexcept  { return delay; }
+
+    /** Appends a block; at most the ring's length minus the delay, or the oldest
+        samples still to come out are overwritten. */
+    void push(const SampleType* source, int numSamples) noexcept
+    {
+        jassert(numSamples <= capacity - delay);
+
+        const int first = juce::jmin(numSamples, capacity - writePosition);
+        std::memcpy(buffer.get() + writePosition, source, sizeof(SampleType) * static_cast<size_t>(first));
+        std::memcpy(buffer.get(), source + first, sizeof(SampleType) * static_cast<size_t>(numSamples - first));
+
+        writePosition = (writePosition + numSamples) & (capacity - 1);
+    }
+
+    /** Copies numSamples, starting at the one pushed age samples before the end of
+        what has been pushed so far. */
+    void read(SampleType* dest, int age, int numSamples) const noexcept
+    {
+        jassert(age >= numSamples && age <= capacity);
+
+        const int start = (writePosition - age) & (capacity - 1);
+        const int first = juce::jmin(numSamples, capacity - start);
+        std::memcpy(dest, buffer.get() + start, sizeof(SampleType) * static_cast<size_t>(first));
+        std::memcpy(dest + first, buffer.get(), sizeof(SampleType) * static_cast<size_t>(numSamples - first));
+    }
+
+    /** Delays a block in place; any length. */
+    void process(SampleType* samples, int numSamples) noexcept
+    {
+        const int maxPiece = capacity - delay;
+
+        for (int done = 0; done < numSamples;)
+        {
+            const int count = juce::jmin(maxPiece, numSamples - done);
+            push(samples + done, count);
+            read(samples + done, count + delay, count);
+            done += count;
+        }
+    }
+
+    /** True if what is still to come out of the delay is below the threshold. */
+    bool hasDecayed(SampleType threshold) const noexcept
+    {
+        for (int age = 1; age <= delay; ++age)
+            if (std::abs(buffer[(writePosition - age) & (capacity - 1)]) > threshold)
+                return false;
+
+        return true;
+    }
+
+private:
+    juce::HeapBlock<SampleType> buffer;
+    int capacity = 0;       // a power of two
+    int delay = 0;
+    int writePosition = 0;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+
+/** What the meters see of one processed block. Levels are linear and taken over
+    all input or all output channels. */
+struct TelemetryRecord
+{
+    float inputRMS = 0.0f;
+    float inputPeak = 0.0f;
+    float outputRMS = 0.0f;
+    float outputPeak = 0.0f;
+    float gainCompensation = 1.0f;      // applied at the end of the block
+    float dephasing = 0.0f;             // in effect at the end of the block, after smoothing and bypass
+    float damping = 0.0f;
+    int numSamples = 0;
+};
+
+/*
+    Wait-free queue of telemetry records from the audio thread to the editor.
+
+    There is one producer, the audio thread, and one consumer, the editor's timer,
+    so the AbstractFifo indices are all the synchronisation needed and neither side
+    ever waits. When the editor falls behind, new records are dropped. The audio
+    thread only measures anything while an editor has enabled the queue.
+*/
+class TelemetryQueue
+{
+public:
+    static constexpr int capacity = 512;
+
+    void setEnabled(bool shouldBeEnabled) noexcept  { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept                 { return enabled.load(std::memory_order_relaxed); }
+
+    bool push(const TelemetryRecord& record) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        records[static_cast<size_t>(size1 > 0 ? start1 : start2)] = record;
+        fifo.finishedWrite(1);
+        return true;
+    }
+
+    bool pop(TelemetryRecord& record) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        record = records[static_cast<size_t>(size1 > 0 ? start1 : start2)];
+        fifo.finishedRead(1);
+        return true;
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<TelemetryRecord, capacity> records;
+    std::atomic<bool> enabled { false };
+};
@@ -0,0 +1,210 @@
+#include "TraceRecorder.h"
+
+class TraceRecorder::Writer : public juce::Thread
+{
+public:
+    explicit Writer(TraceRecorder& ownerRecorder)
+        : juce::Thread("Lazirko trace writer"), recorder(ownerRecorder)
+    {
+        startThread();
+    }
+
+    ~Writer() override
+    {
+        stopThread(2000);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            // Empties a ring long before it fills at any host block size
+            wait(flushIntervalMs);
+            recorder.drain(recorder.stream.get());
+        }
+    }
+
+private:
+    TraceRecorder& recorder;
+
+    static constexpr int flushIntervalMs = 10;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Writer)
+};
+
+//==============================================================================
+namespace
+{
+    std::atomic<std::uint64_t> nextRecorderId { 1 };
+}
+
+TraceRecorder::TraceRecorder()
+    : id(nextRecorderId.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    stop();
+}
+
+bool TraceRecorder::start(const juce::File& file)
+{
+    stop();
+
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+
+    auto newStream = std::make_unique<juce::FileOutputStream>(file);
+    if (! newStream->openedOk())
+        return false;
+
+    for (auto& ring : rings)
+        if (ring.events == nullptr)
+            ring.events = std::make_unique<Event[]>(static_cast<size_t>(ringCapacity));
+
+    // Whatever the last trace left behind in the rings
+    drain(nullptr);
+
+    // The timestamps are converted with the profiler's calibration of the counter
+    CpuProfiler::getCyclesPerSecond();
+
+    stream = std::move(newStream);
+    *stream << "{\"traceEvents\":[\n"
+               "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Quantum Noise Channel\"}}";
+
+    numDropped.store(0, std::memory_order_relaxed);
+    origin = CpuProfiler::readCycleCounter();
+    recording.store(true, std::memory_order_release);
+
+    writer = std::make_unique<Writer>(*this);
+    return true;
+}
+
+void TraceRecorder::stop()
+{
+    if (stream == nullptr)
+        return;
+
+    recording.store(false, std::memory_order_release);
+    writer.reset();
+
+    drain(stream.get());
+
+    *stream << "\n]}\n";
+    stream->flush();
+    stream.reset();
+}
+
+void TraceRecorder::add(const char* name, std::uint64_t start, std::uint64_t end) noexcept
+{
+    auto* ring = getRingForThisThread();
+
+    int start1, size1, start2, size2;
+
+    if (ring != nullptr)
+        ring->fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (ring == nullptr || size1 + size2 == 0)
+    {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->events[static_cast<size_t>(size1 > 0 ? start1 : start2)] = { name, start, end };
+    ring->fifo.finishedWrite(1);
+}
+
+TraceRecorder::Ring* TraceRecorder::getRingForThisThread() noexcept
+{
+    // The last ring this thread used, so that the search only runs when a thread
+    // records for a different recorder than last time. Recorders are told apart by
+    // id, as a new one may be created at the address of a deleted one.
+    thread_local std::uint64_t cachedRecorderId = 0;
+    thread_local Ring* cachedRing = nullptr;
+
+    if (cachedRecorderId == id)
+        return cachedRing;
+
+    const auto thread = juce::Thread::getCurrentThreadId();
+    Ring* found = nullptr;
+
+    for (auto& ring : rings)
+    {
+        if (ring.owner.load(std::memory_order_acquire) == thread)
+        {
+            found = &ring;
+            break;
+        }
+    }
+
+    for (auto& ring : rings)
+    {
+        if (found != nullptr)
+            break;
+
+        juce::Thread::ThreadID unowned = nullptr;
+        if (ring.owner.compare_exchange_strong(unowned, thread, std::memory_order_acq_rel))
+            found = &ring;
+    }
+
+    // Threads without a ring look again next time
+    if (found != nullptr)
+    {
+        cachedRecorderId = id;
+        cachedRing = found;
+    }
+
+    return found;
+}
+
+void TraceRecorder::drain(juce::OutputStream* output)
+{
+    const double microsecondsPerCycle = 1.0e6 / CpuProfiler::getCyclesPerSecond();
+    juce::String text;
+
+    for (size_t index = 0; index < rings.size(); ++index)
+    {
+        auto& ring = rings[index];
+
+        if (ring.events == nullptr)
+            continue;
+
+        const int numReady = ring.fifo.getNumReady();
+
+        if (numReady == 0)
+            continue;
+
+        int start1, size1, start2, size2;
+        ring.fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+        if (output != nullptr)
+        {
+            auto write = [&] (int start, int size)
+            {
+                for (int i = start; i < start + size; ++i)
+                {
+                    const auto& event = ring.events[static_cast<size_t>(i)];
+
+                    // Events recorded before start() by a racing thread
+                    if (event.start < origin)
+                        continue;
+
+                    text << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                         << static_cast<int>(index)
+                         << ",\"ts\":" << juce::String(static_cast<double>(event.start - origin) * microsecondsPerCycle, 3)
+                         << ",\"dur\":" << juce::String(static_cast<double>(event.end - event.start) * microsecondsPerCycle, 3)
+                         << "}";
+                }
+            };
+
+            write(start1, size1);
+            write(start2, size2);
+        }
+
+        ring.fifo.finishedRead(size1 + size2);
+    }
+
+    if (output != nullptr && text.isNotEmpty())
+        *output << text;
+}
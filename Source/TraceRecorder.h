@@ -0,0 +1,107 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "CpuProfiler.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/*
+    Timeline of the processing stages, written as Chrome trace-event JSON for
+    chrome://tracing, Perfetto or any other trace viewer.
+
+    Every stage that runs under a ScopedEvent adds one complete event, its name and
+    the cycle counter at its start and end, to a ring of the thread it runs on. A
+    thread claims a ring the first time it records and keeps it, so every ring has
+    a single producer and needs no lock; the rings are allocated by start(), never
+    on the audio thread. A background thread empties the rings every few
+    milliseconds and appends the events to the file. Events that find their ring
+    full, or no ring left to claim, are dropped and counted.
+
+    While not started, a ScopedEvent costs one load and a branch.
+*/
+class TraceRecorder
+{
+public:
+    static constexpr int maxThreads = 32;
+    static constexpr int ringCapacity = 8192;
+
+    TraceRecorder();
+    ~TraceRecorder();
+
+    /** Starts writing events to a new trace file, replacing any file of that name.
+        Call from the message thread; returns false if the file can't be opened. */
+    bool start(const juce::File& file);
+
+    /** Writes the events still in the rings, closes the trace and waits for the
+        writer thread. Events recorded while this runs may be lost. */
+    void stop();
+
+    bool isRecording() const noexcept  { return recording.load(std::memory_order_acquire); }
+
+    /** Events dropped since start() because a ring was full or there was none. */
+    int getNumDroppedEvents() const noexcept  { return numDropped.load(std::memory_order_relaxed); }
+
+    /** Records its own lifetime as one event. The name must outlive the trace, which
+        string literals do. */
+    class ScopedEvent
+    {
+    public:
+        ScopedEvent(TraceRecorder& recorderToUse, const char* eventName) noexcept
+            : recorder(recorderToUse.isRecording() ? &recorderToUse : nullptr),
+              name(eventName),
+              start(recorder != nullptr ? CpuProfiler::readCycleCounter() : 0)
+        {
+        }
+
+        ~ScopedEvent() noexcept
+        {
+            if (recorder != nullptr)
+                recorder->add(name, start, CpuProfiler::readCycleCounter());
+        }
+
+    private:
+        TraceRecorder* recorder;
+        const char* name;
+        std::uint64_t start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedEvent)
+    };
+
+private:
+    class Writer;
+
+    struct Event
+    {
+        const char* name;
+        std::uint64_t start, end;
+    };
+
+    struct Ring
+    {
+        std::atomic<juce::Thread::ThreadID> owner { nullptr };
+        juce::AbstractFifo fifo { ringCapacity };
+        std::unique_ptr<Event[]> events;
+    };
+
+    void add(const char* name, std::uint64_t start, std::uint64_t end) noexcept;
+    Ring* getRingForThisThread() noexcept;
+
+    // Moves every queued event to the file (or nowhere, if there is no file yet);
+    // only one thread at a time may drain
+    void drain(juce::OutputStream* stream);
+
+    const std::uint64_t id;
+    std::array<Ring, maxThreads> rings;
+    std::atomic<bool> recording { false };
+    std::atomic<int> numDropped { 0 };
+
+    std::unique_ptr<juce::FileOutputStream> stream;
+    std::unique_ptr<Writer> writer;
+    std::uint64_t origin = 0;       // counter value at start(), time zero of the trace
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceRecorder)
+};
@@ -0,0 +1,28 @@
+/*
+    LazirkoTests: unit tests of the DSP core, run by CTest.
+
+    Runs every juce::UnitTest in the "Lazirko" category and exits with a non-zero
+    status if any expectation failed. Pass a test name to run only that test.
+*/
+
+#include <JuceHeader.h>
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if (argc > 1)
+        runner.runTestsWithName(juce::CharPointer_UTF8(argv[1]));
+    else
+        runner.runTestsInCategory("Lazirko");
+
+    int numFailures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult(i)->failures;
+
+    return numFailures > 0 || runner.getNumResults() == 0 ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#include <JuceHeader.h>
+
+#include "../../Source/Oversampler.h"
+
+#include <vector>
+
+class OversamplerTests : public juce::UnitTest
+{
+public:
+    OversamplerTests() : juce::UnitTest("Oversampler", "Lazirko") {}
+
+    void runTest() override
+    {
+        constexpr int chunkSize = 256;
+        constexpr int length = 4096;
+
+        for (auto filterType : { Oversampler::lowLatency, Oversampler::linearPhase })
+        {
+            const juce::String filterName = filterType == Oversampler::linearPhase ? "linear-phase" : "low-latency";
+
+            for (int factor : { 2, 4, 8 })
+            {
+                beginTest(juce::String(factor) + "x " + filterName + " latency matches an impulse round trip");
+
+                Oversampler oversampler;
+                oversampler.prepare(factor, filterType, chunkSize);
+
+                const int latency = oversampler.getLatency();
+                expectEquals(Oversampler::getLatencyFor(factor, filterType), latency);
+
+                // The centroid of the impulse response is its delay at DC. The last
+                // fraction of a sample is made up at the top rate, exactly for the FIR
+                // and to the nearest top-rate sample for the IIR.
+                std::vector<float> chunk(chunkSize);
+                double sum = 0.0, moment = 0.0;
+
+                for (int start = 0; start < length; start += chunkSize)
+                {
+                    std::fill(chunk.begin(), chunk.end(), 0.0f);
+
+                    if (start == 0)
+                        chunk[0] = 1.0f;
+
+                    oversampler.upsample(chunk.data(), chunkSize);
+                    oversampler.downsample(chunk.data(), chunkSize);
+
+                    for (int n = 0; n < chunkSize; ++n)
+                    {
+                        sum += chunk[static_cast<size_t>(n)];
+                        moment += static_cast<double>(start + n) * chunk[static_cast<size_t>(n)];
+                    }
+                }
+
+                const double tolerance = filterType == Oversampler::linearPhase ? 1.0e-3 : 0.5 / factor + 1.0e-3;
+                expectWithinAbsoluteError(moment / sum, static_cast<double>(latency), tolerance);
+                expectWithinAbsoluteError(sum, 1.0, 1.0e-3);
+
+                beginTest(juce::String(factor) + "x " + filterName + " delay() has the same latency");
+
+                oversampler.reset();
+                std::fill(chunk.begin(), chunk.end(), 0.0f);
+                chunk[0] = 1.0f;
+                oversampler.delay(chunk.data(), chunkSize);
+
+                std::vector<float> expected(chunkSize, 0.0f);
+                expected[static_cast<size_t>(latency)] = 1.0f;
+                expect(chunk == expected);
+            }
+        }
+    }
+};
+
+static OversamplerTests oversamplerTests;
@@ -0,0 +1,277 @@
+#include <JuceHeader.h>
+
+#include "../../Source/AllocationGuard.h"
+#include "../../Source/PluginProcessor.h"
+
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    using Settings = std::vector<std::pair<juce::String, float>>;
+
+    void setParameter(LazirkoAudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        auto* parameter = processor.getAPVTS().getParameter(parameterID);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    // Two tones under broadband noise, with a short burst every 100 ms so that T/S
+    // has transients to separate
+    juce::AudioBuffer<float> makeInput(int numChannels, int numSamples)
+    {
+        juce::AudioBuffer<float> input(numChannels, numSamples);
+        juce::Random random(1234);
+
+        const int burstPeriod = static_cast<int>(0.1 * sampleRate);
+        const float twoPi = juce::MathConstants<float>::twoPi;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* data = input.getWritePointer(ch);
+            const float frequency = 220.0f * (1.0f + 0.5f * static_cast<float>(ch));
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                const float tone = 0.4f * std::sin(twoPi * frequency * static_cast<float>(n / sampleRate));
+                const float noise = 0.1f * (random.nextFloat() * 2.0f - 1.0f);
+                const float burst = (n % burstPeriod) < 64 ? 0.5f : 0.0f;
+                data[n] = tone + noise + burst;
+            }
+        }
+
+        return input;
+    }
+
+    std::unique_ptr<LazirkoAudioProcessor> createProcessor(int numChannels, int blockSize, const Settings& settings)
+    {
+        auto processor = std::make_unique<LazirkoAudioProcessor>();
+
+        for (const auto& [parameterID, value] : settings)
+            setParameter(*processor, parameterID, value);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+        layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+        processor->setBusesLayout(layout);
+
+        processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor->prepareToPlay(sampleRate, blockSize);
+        processor->setNoiseSeed(99);
+        return processor;
+    }
+
+    // Runs the input through in blocks of blockSize, the last one shorter
+    juce::AudioBuffer<float> render(LazirkoAudioProcessor& processor, const juce::AudioBuffer<float>& input, int blockSize)
+    {
+        const int numChannels = input.getNumChannels();
+        juce::AudioBuffer<float> output(numChannels, input.getNumSamples());
+        juce::AudioBuffer<float> block(numChannels, blockSize);
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start < input.getNumSamples(); start += blockSize)
+        {
+            const int count = juce::jmin(blockSize, input.getNumSamples() - start);
+            block.setSize(numChannels, count, false, false, true);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                block.copyFrom(ch, 0, input, ch, start, count);
+
+            processor.processBlock(block, midi);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                output.copyFrom(ch, start, block, ch, 0, count);
+        }
+
+        return output;
+    }
+
+    // Renders the input as LazirkoRender's parallel renders do: in chunks, each by its
+    // own processor that starts warmUpLength samples early with the noise seeked there
+    juce::AudioBuffer<float> renderInChunks(const Settings& settings, const juce::AudioBuffer<float>& input,
+                                            int blockSize, int chunkLength, int warmUpLength)
+    {
+        const int numChannels = input.getNumChannels();
+        juce::AudioBuffer<float> output(numChannels, input.getNumSamples());
+
+        for (int chunkStart = 0; chunkStart < input.getNumSamples(); chunkStart += chunkLength)
+        {
+            const int from = juce::jmax(0, chunkStart - warmUpLength);
+            const int to = juce::jmin(input.getNumSamples(), chunkStart + chunkLength);
+
+            juce::AudioBuffer<float> piece(numChannels, to - from);
+            for (int ch = 0; ch < numChannels; ++ch)
+                piece.copyFrom(ch, 0, input, ch, from, to - from);
+
+            auto processor = createProcessor(numChannels, blockSize, settings);
+            processor->setNoisePosition(static_cast<juce::uint64>(from));
+            const auto rendered = render(*processor, piece, blockSize);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                output.copyFrom(ch, chunkStart, rendered, ch, chunkStart - from, to - chunkStart);
+        }
+
+        return output;
+    }
+
+    float getMaxDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b, int startSample = 0)
+    {
+        float maxDifference = 0.0f;
+
+        for (int ch = 0; ch < a.getNumChannels(); ++ch)
+            for (int n = startSample; n < a.getNumSamples(); ++n)
+                maxDifference = juce::jmax(maxDifference, std::abs(a.getSample(ch, n) - b.getSample(ch, n)));
+
+        return maxDifference;
+    }
+
+    juce::String describe(const Settings& settings)
+    {
+        juce::StringArray parts;
+
+        for (const auto& [parameterID, value] : settings)
+            parts.add(parameterID + "=" + juce::String(value));
+
+        return parts.joinIntoString(" ");
+    }
+}
+
+class ProcessorTests : public juce::UnitTest
+{
+public:
+    ProcessorTests() : juce::UnitTest("Processor", "Lazirko") {}
+
+    void runTest() override
+    {
+        const int numSamples = static_cast<int>(sampleRate);
+
+        beginTest("Output does not depend on the host block size");
+
+        // MODE is Mono, L/R, M/S, T/S or Multiband
+        for (int mode = 0; mode < 5; ++mode)
+        {
+            for (float autoGain : { 0.0f, 1.0f })
+            {
+                const Settings settings { { "MODE", static_cast<float>(mode) }, { "DEPHASE", 0.6f }, { "DAMPING", 0.4f },
+                                          { "MIX", 0.8f }, { "AUTOGAIN", autoGain } };
+
+                for (int numChannels : { 1, 2 })
+                {
+                    const auto input = makeInput(numChannels, numSamples);
+                    auto reference = createProcessor(numChannels, 512, settings);
+                    const auto expected = render(*reference, input, 512);
+
+                    for (int blockSize : { 1, 37, 1000, 8192 })
+                    {
+                        auto processor = createProcessor(numChannels, blockSize, settings);
+                        const auto actual = render(*processor, input, blockSize);
+
+                        expect(getMaxDifference(expected, actual) == 0.0f,
+                               describe(settings) + ", " + juce::String(numChannels) + " channels, blocks of "
+                                   + juce::String(blockSize) + ": differs by " + juce::String(getMaxDifference(expected, actual)));
+                    }
+                }
+            }
+        }
+
+        beginTest("A render in warmed-up chunks matches a serial one");
+
+        // OVERSAMPLING 2 is 4x, OVERSAMPLING_FILTER 0 the IIR filters, QUALITY 1 Realtime
+        for (float autoGain : { 0.0f, 1.0f })
+        {
+            const double settlingSeconds = autoGain > 0.5f ? LazirkoAudioProcessor::autoGainSettlingSeconds
+                                                           : LazirkoAudioProcessor::settlingSeconds;
+
+            constexpr int blockSize = 512;
+            const int warmUpLength = (static_cast<int>(settlingSeconds * sampleRate) + blockSize - 1) / blockSize * blockSize;
+            const int chunkLength = 4 * warmUpLength;
+
+            for (int mode = 0; mode < 5; ++mode)
+            {
+                const Settings settings { { "MODE", static_cast<float>(mode) }, { "DEPHASE", 0.6f }, { "DAMPING", 0.4f },
+                                          { "MIX", 0.8f }, { "AUTOGAIN", autoGain }, { "OVERSAMPLING", 2.0f },
+                                          { "OVERSAMPLING_FILTER", 0.0f }, { "QUALITY", 1.0f } };
+
+                const auto input = makeInput(2, 3 * chunkLength);
+                auto serial = createProcessor(2, blockSize, settings);
+                const auto expected = render(*serial, input, blockSize);
+                const auto actual = renderInChunks(settings, input, blockSize, chunkLength, warmUpLength);
+
+                expect(getMaxDifference(expected, actual) == 0.0f,
+                       describe(settings) + ": differs by " + juce::String(getMaxDifference(expected, actual)));
+            }
+        }
+
+        beginTest("Bypass passes the input through unchanged");
+
+        for (int mode = 0; mode < 5; ++mode)
+        {
+            const Settings settings { { "MODE", static_cast<float>(mode) }, { "DEPHASE", 0.6f }, { "DAMPING", 0.4f },
+                                      { "AUTOGAIN", 1.0f }, { "BYPASS", 1.0f } };
+
+            const auto input = makeInput(2, numSamples);
+            auto processor = createProcessor(2, 512, settings);
+            const auto output = render(*processor, input, 512);
+
+            expect(getMaxDifference(input, output) == 0.0f, describe(settings));
+        }
+
+        beginTest("Auto keeps the playback latency in an offline bounce");
+
+        for (int filter = 0; filter < 2; ++filter)
+        {
+            for (int oversampling = 0; oversampling < 4; ++oversampling)
+            {
+                const Settings settings { { "DAMPING", 0.4f }, { "OVERSAMPLING", static_cast<float>(oversampling) },
+                                          { "OVERSAMPLING_FILTER", static_cast<float>(filter) }, { "QUALITY", 0.0f } };
+
+                auto processor = createProcessor(2, 512, settings);
+                const int playbackLatency = processor->getLatencySamples();
+
+                processor->setNonRealtime(true);
+                processor->prepareToPlay(sampleRate, 512);
+
+                expect(processor->isRenderQuality(), describe(settings));
+                expectEquals(processor->getLatencySamples(), playbackLatency, describe(settings));
+            }
+        }
+
+        beginTest("Neutral settings pass the input through unchanged");
+
+        // MODE 1 and 2 are L/R and M/S, which are the identity without dephasing and damping
+        for (int mode : { 1, 2 })
+        {
+            for (float mix : { 0.0f, 0.5f, 1.0f })
+            {
+                const Settings settings { { "MODE", static_cast<float>(mode) }, { "DEPHASE", 0.0f }, { "DAMPING", 0.0f },
+                                          { "MIX", mix }, { "AUTOGAIN", 0.0f } };
+
+                const auto input = makeInput(2, numSamples);
+                auto processor = createProcessor(2, 512, settings);
+                const auto output = render(*processor, input, 512);
+
+                expect(getMaxDifference(input, output) == 0.0f, describe(settings));
+            }
+        }
+
+        beginTest("processBlock does not allocate");
+
+        for (int mode = 0; mode < 5; ++mode)
+        {
+            const Settings settings { { "MODE", static_cast<float>(mode) }, { "DEPHASE", 0.6f }, { "DAMPING", 0.4f },
+                                      { "AUTOGAIN", 1.0f }, { "OVERSAMPLING", 2.0f } };
+
+            const auto input = makeInput(2, numSamples);
+            auto processor = createProcessor(2, 512, settings);
+
+            // Counts only where the guard is compiled in; elsewhere this passes trivially
+            const int violationsBefore = AllocationGuard::getNumViolations();
+            render(*processor, input, 512);
+            expectEquals(AllocationGuard::getNumViolations(), violationsBefore, describe(settings));
+        }
+    }
+};
+
+static ProcessorTests processorTests;
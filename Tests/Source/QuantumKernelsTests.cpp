@@ -0,0 +1,166 @@
+#include <JuceHeader.h>
+
+#include "../../Source/QuantumKernels.h"
+
+#include <vector>
+
+namespace
+{
+    // The accuracy QuantumKernels.h promises: dephasing within 2e-6 of the amplitude
+    // magnitude, the whole channel within 2e-4 for states in [-4, 4]
+    constexpr float dephaseTolerance = 2.0e-6f;
+    constexpr float dampTolerance = 2.0e-4f;
+
+    // Odd lengths, so that the SIMD kernels run their scalar tails too
+    constexpr int numSamples = 1027;
+
+    struct State
+    {
+        std::vector<float> re, im;
+    };
+
+    State makeState(juce::Random& random)
+    {
+        State state { std::vector<float>(numSamples), std::vector<float>(numSamples) };
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            state.re[static_cast<size_t>(n)] = random.nextFloat() * 8.0f - 4.0f;
+            state.im[static_cast<size_t>(n)] = random.nextFloat() * 8.0f - 4.0f;
+        }
+
+        // A few amplitudes at and around the magnitude threshold
+        state.re[0] = state.im[0] = 0.0f;
+        state.re[1] = 1.0e-13f;
+        state.im[1] = 0.0f;
+        return state;
+    }
+
+    std::vector<float> makeRamp(float start, float end)
+    {
+        std::vector<float> ramp(numSamples);
+
+        for (int n = 0; n < numSamples; ++n)
+            ramp[static_cast<size_t>(n)] = start + (end - start) * static_cast<float>(n) / (numSamples - 1);
+
+        return ramp;
+    }
+}
+
+class QuantumKernelsTests : public juce::UnitTest
+{
+public:
+    QuantumKernelsTests() : juce::UnitTest("Quantum kernels", "Lazirko") {}
+
+    void runTest() override
+    {
+        juce::Random random(42);
+        const auto& scalar = QuantumKernels::getScalarKernels();
+
+        std::vector<float> noise(numSamples);
+        for (auto& value : noise)
+            value = random.nextFloat();
+
+        for (const auto* table : QuantumKernels::getAllKernels())
+        {
+            const juce::String name(table->name);
+
+            beginTest(name + " dephasing matches the scalar kernels");
+
+            for (float amount : { 0.0f, 0.25f, 0.5f, 1.0f })
+            {
+                const auto input = makeState(random);
+                auto expected = input, actual = input;
+
+                scalar.dephase(expected.re.data(), expected.im.data(), noise.data(), numSamples, amount);
+                table->dephase(actual.re.data(), actual.im.data(), noise.data(), numSamples, amount);
+                expectDephaseWithin(input, expected, actual);
+            }
+
+            {
+                const auto input = makeState(random);
+                const auto amounts = makeRamp(0.0f, 1.0f);
+                auto expected = input, actual = input;
+
+                QuantumKernels::dephaseRampScalar(expected.re.data(), expected.im.data(), noise.data(), numSamples, amounts.data());
+                table->dephaseRamp(actual.re.data(), actual.im.data(), noise.data(), numSamples, amounts.data());
+                expectDephaseWithin(input, expected, actual);
+            }
+
+            beginTest(name + " damping matches the scalar kernels");
+
+            for (float amount : { 0.0f, 0.3f, 0.7f, 1.0f })
+            {
+                const auto input = makeState(random);
+                auto expected = input, actual = input;
+
+                scalar.damp(expected.re.data(), expected.im.data(), numSamples, amount);
+                table->damp(actual.re.data(), actual.im.data(), numSamples, amount);
+                expectWithin(expected.re, actual.re, dampTolerance);
+                expectWithin(expected.im, actual.im, dampTolerance);
+
+                auto real = input.re;
+                table->dampReal(real.data(), numSamples, amount);
+                expectWithin(expected.re, real, dampTolerance);
+            }
+
+            {
+                const auto input = makeState(random);
+                const auto amounts = makeRamp(1.0f, 0.0f);
+                auto expected = input, actual = input;
+
+                QuantumKernels::dampRampScalar(expected.re.data(), expected.im.data(), numSamples, amounts.data());
+                table->dampRamp(actual.re.data(), actual.im.data(), numSamples, amounts.data());
+                expectWithin(expected.re, actual.re, dampTolerance);
+                expectWithin(expected.im, actual.im, dampTolerance);
+
+                auto real = input.re;
+                table->dampRealRamp(real.data(), numSamples, amounts.data());
+                expectWithin(expected.re, real, dampTolerance);
+            }
+
+            beginTest(name + " noise is the same as the scalar kernels'");
+
+            {
+                const QuantumKernels::NoiseKey key { 0x01234567u, 0x89abcdefu, 3 };
+                constexpr int numGroups = 37;
+                std::vector<float> expected(numGroups * QuantumKernels::noiseGroupSize);
+                std::vector<float> actual(expected.size());
+
+                for (uint64_t firstGroup : { uint64_t { 0 }, uint64_t { 12345 }, uint64_t { 1 } << 40 })
+                {
+                    scalar.fillNoise(expected.data(), firstGroup, numGroups, key);
+                    table->fillNoise(actual.data(), firstGroup, numGroups, key);
+                    expect(expected == actual, "noise differs from group " + juce::String(static_cast<juce::int64>(firstGroup)));
+                }
+            }
+        }
+    }
+
+private:
+    void expectWithin(const std::vector<float>& expected, const std::vector<float>& actual, float tolerance)
+    {
+        float maxError = 0.0f;
+
+        for (size_t n = 0; n < expected.size(); ++n)
+            maxError = juce::jmax(maxError, std::abs(expected[n] - actual[n]));
+
+        expect(maxError <= tolerance, "error " + juce::String(maxError) + " above " + juce::String(tolerance));
+    }
+
+    void expectDephaseWithin(const State& input, const State& expected, const State& actual)
+    {
+        float maxError = 0.0f;
+
+        for (size_t n = 0; n < input.re.size(); ++n)
+        {
+            const float magnitude = std::sqrt(input.re[n] * input.re[n] + input.im[n] * input.im[n]);
+            const float error = juce::jmax(std::abs(expected.re[n] - actual.re[n]), std::abs(expected.im[n] - actual.im[n]));
+            maxError = juce::jmax(maxError, error / juce::jmax(magnitude, 1.0e-6f));
+        }
+
+        expect(maxError <= dephaseTolerance, "relative error " + juce::String(maxError) + " above " + juce::String(dephaseTolerance));
+    }
+};
+
+static QuantumKernelsTests quantumKernelsTests;
@@ -0,0 +1,87 @@
+#include <JuceHeader.h>
+
+#include "../../Source/QuantumNoise.h"
+
+#include <algorithm>
+#include <vector>
+
+class QuantumNoiseTests : public juce::UnitTest
+{
+public:
+    QuantumNoiseTests() : juce::UnitTest("Quantum noise", "Lazirko") {}
+
+    void runTest() override
+    {
+        constexpr int length = 5000;
+        constexpr juce::uint64 seed = 0x5eed5eed5eedull;
+
+        QuantumNoise noise;
+        noise.setSeed(seed);
+        noise.setStream(1);
+
+        std::vector<float> reference(length);
+        noise.fill(reference.data(), length);
+
+        beginTest("Values are in [0, 1)");
+
+        expect(std::all_of(reference.begin(), reference.end(), [] (float value) { return value >= 0.0f && value < 1.0f; }));
+        expectEquals(static_cast<juce::int64>(noise.getPosition()), static_cast<juce::int64>(length));
+
+        beginTest("Any split into chunks gives the same stream");
+
+        juce::Random random(7);
+
+        for (int pass = 0; pass < 20; ++pass)
+        {
+            // Chunks of 1 to 40 samples mostly start and end inside a noise group
+            const int maxChunk = pass < 10 ? 40 : 1000;
+            std::vector<float> chunked(length);
+
+            noise.seek(0);
+
+            for (int start = 0; start < length;)
+            {
+                const int count = juce::jmin(length - start, 1 + random.nextInt(maxChunk));
+                noise.fill(chunked.data() + start, count);
+                start += count;
+            }
+
+            expect(chunked == reference, "chunked stream differs in pass " + juce::String(pass));
+        }
+
+        beginTest("Seeking reproduces the stream from any position");
+
+        for (int pass = 0; pass < 50; ++pass)
+        {
+            const int position = random.nextInt(length - 100);
+            const int count = 1 + random.nextInt(99);
+            std::vector<float> values(static_cast<size_t>(count));
+
+            noise.seek(static_cast<juce::uint64>(position));
+            noise.fill(values.data(), count);
+
+            expect(std::equal(values.begin(), values.end(), reference.begin() + position),
+                   "stream differs after seeking to " + juce::String(position));
+        }
+
+        beginTest("Streams and seeds are independent");
+
+        {
+            QuantumNoise other;
+            other.setSeed(seed);
+            other.setStream(2);
+
+            std::vector<float> values(length);
+            other.fill(values.data(), length);
+            expect(values != reference);
+
+            other.setSeed(seed + 1);
+            other.setStream(1);
+            other.seek(0);
+            other.fill(values.data(), length);
+            expect(values != reference);
+        }
+    }
+};
+
+static QuantumNoiseTests quantumNoiseTests;
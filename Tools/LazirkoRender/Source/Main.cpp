@@ -0,0 +1,632 @@
+/*
+    LazirkoRender: headless offline renderer for the Quantum Noise Channel.
+
+    Streams an audio file through LazirkoAudioProcessor::processBlock in large
+    blocks and writes the result, holding only one block in memory. Long files are
+    split into chunks rendered in parallel by their own processor instances. It
+    links the processor together with the headless JUCE audio modules only, so it
+    runs on machines without a display.
+
+    Parallel renders match a serial one: every chunk starts on a block boundary,
+    seeks the noise to its own position and is warmed up on the preceding audio
+    (one second, two with auto-gain, whose loudness window and gain ramp take
+    longer to settle), so the result is bit-identical.
+
+    Parameter automation is queued sample-accurately: the processor splits each
+    block at the automation points that fall inside it.
+*/
+
+#include <JuceHeader.h>
+
+#include "../../../Source/PluginProcessor.h"
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <map>
+
+namespace
+{
+    /** A parameter change at a stream position, in plain parameter units. */
+    struct AutomationEvent
+    {
+        juce::int64 position = 0;
+        juce::String parameterID;
+        float value = 0.0f;
+    };
+
+    struct RenderSettings
+    {
+        juce::File stateFile;
+        juce::StringPairArray parameterValues;   // parameter ID -> value, in command-line order
+        juce::StringPairArray automation;        // parameter ID -> "seconds:value,seconds:value..."
+        bool hasSeed = false;
+        juce::uint64 seed = 0;
+        int blockSize = 8192;
+        int bitDepth = 0;                        // 0 = same as the input
+        int numThreads = 1;
+        CpuProfiler* profile = nullptr;          // collects every processor's timings, with --profile
+        TraceRecorder* trace = nullptr;          // records every processor's stages, with --trace
+    };
+
+    // Longest tail we render after the input ends, for processors reporting an infinite one
+    constexpr double maxTailSeconds = 30.0;
+
+    // Parallel renders split the file into chunks of this length, and run each one in
+    // from the processor's settling time before its start
+    constexpr double chunkSeconds = 20.0;
+
+    void printUsage()
+    {
+        std::cout << "Usage:\n"
+                     "  LazirkoRender [options] <input> <output>\n"
+                     "  LazirkoRender [options] --output-dir <dir> <input>...\n"
+                     "\n"
+                     "Options:\n"
+                     "  --mode <Mono|L/R|M/S|T/S|Multiband>\n"
+                     "                              processing mode (or its index 0-4)\n"
+                     "  --dephase <0..1>            dephasing amount\n"
+                     "  --damping <0..1>            damping amount\n"
+                     "  --mix <0..1>                dry/wet mix\n"
+                     "  --autogain <on|off>         automatic gain compensation\n"
+                     "  --oversampling <Off|2x|4x|8x>\n"
+                     "                              oversampling of the damping stage\n"
+                     "  --oversampling-filter <0|1> 0: low-latency IIR, 1: linear-phase FIR\n"
+                     "  --quality <Auto|Realtime|Render>\n"
+                     "                              processing tier; Auto uses Render's kernels\n"
+                     "                              but not its oversampling\n"
+                     "  --set <ID>=<value>          any parameter by ID; may be repeated\n"
+                     "  --automate <ID>=<t>:<value>[,<t>:<value>...]\n"
+                     "                              step a parameter to each value at time t (seconds),\n"
+                     "                              sample-accurately; may be repeated\n"
+                     "  --state <file>              preset: parameter XML or a saved plugin state\n"
+                     "  --seed <n>                  dephasing noise seed, for reproducible renders\n"
+                     "  --block-size <n>            samples per processBlock call (default 8192)\n"
+                     "  --bits <n>                  output bit depth (default: same as input)\n"
+                     "  --threads <n>               render long files on n threads (default: all cores)\n"
+                     "  --profile <file>            write processing times and real-time budget use to file\n"
+                     "  --trace <file>              write a Chrome trace-event timeline of the processing stages\n"
+                     "\n"
+                     "Reads and writes every format JUCE registers by default (WAV, AIFF, FLAC, ...);\n"
+                     "the output format follows the output file extension.\n";
+    }
+
+    bool fail(const juce::String& message)
+    {
+        std::cerr << "LazirkoRender: " << message << std::endl;
+        return false;
+    }
+
+    bool isNumber(const juce::String& text)
+    {
+        return text.isNotEmpty() && text.containsOnly("0123456789.-+eE");
+    }
+
+    // Numbers are plain parameter values (choice index, 0/1 for switches); anything
+    // else goes through the parameter's own text parser, e.g. "M/S" or "on"
+    float getNormalisedValue(const juce::RangedAudioParameter& parameter, const juce::String& text)
+    {
+        const float normalised = isNumber(text) ? parameter.convertTo0to1(text.getFloatValue())
+                                                : parameter.getValueForText(text);
+
+        return juce::jlimit(0.0f, 1.0f, normalised);
+    }
+
+    bool applyParameter(juce::AudioProcessorValueTreeState& parameters, const juce::String& parameterID,
+                        const juce::String& text)
+    {
+        auto* parameter = parameters.getParameter(parameterID);
+        if (parameter == nullptr)
+            return fail("unknown parameter '" + parameterID + "'");
+
+        parameter->setValueNotifyingHost(getNormalisedValue(*parameter, text));
+        return true;
+    }
+
+    /** Turns the --automate lists into events ordered by position. */
+    bool parseAutomation(const RenderSettings& settings, juce::AudioProcessorValueTreeState& parameters,
+                         double sampleRate, std::vector<AutomationEvent>& events)
+    {
+        for (auto& parameterID : settings.automation.getAllKeys())
+        {
+            auto* parameter = parameters.getParameter(parameterID);
+            if (parameter == nullptr)
+                return fail("unknown parameter '" + parameterID + "'");
+
+            for (auto& point : juce::StringArray::fromTokens(settings.automation[parameterID], ",", {}))
+            {
+                const auto time = point.upToFirstOccurrenceOf(":", false, false).trim();
+                const auto value = point.fromFirstOccurrenceOf(":", false, false).trim();
+
+                if (! isNumber(time) || value.isEmpty() || time.getDoubleValue() < 0.0)
+                    return fail("bad automation point '" + point + "' for " + parameterID);
+
+                events.push_back({ static_cast<juce::int64>(std::llround(time.getDoubleValue() * sampleRate)), parameterID,
+                                   parameter->convertFrom0to1(getNormalisedValue(*parameter, value)) });
+            }
+        }
+
+        std::stable_sort(events.begin(), events.end(),
+                         [] (const AutomationEvent& a, const AutomationEvent& b) { return a.position < b.position; });
+        return true;
+    }
+
+    bool loadState(LazirkoAudioProcessor& processor, const juce::File& file)
+    {
+        juce::MemoryBlock data;
+
+        if (auto xml = juce::XmlDocument::parse(file))
+            juce::AudioProcessor::copyXmlToBinary(*xml, data);
+        else if (! file.loadFileAsData(data))
+            return fail("can't read state file " + file.getFullPathName());
+
+        processor.setStateInformation(data.getData(), static_cast<int>(data.getSize()));
+        return true;
+    }
+
+    int chooseBitDepth(juce::AudioFormat& format, int requested)
+    {
+        auto depths = format.getPossibleBitDepths();
+        if (depths.contains(requested) || depths.isEmpty())
+            return requested;
+
+        // Highest supported depth not above the request, else the lowest there is
+        int best = depths.getFirst();
+        for (auto depth : depths)
+            if (depth <= requested && depth > best)
+                best = depth;
+
+        return best;
+    }
+
+    std::unique_ptr<LazirkoAudioProcessor> createProcessor(const RenderSettings& settings, int numChannels,
+                                                           double sampleRate, juce::uint64 seed)
+    {
+        auto processor = std::make_unique<LazirkoAudioProcessor>();
+
+        if (settings.stateFile != juce::File() && ! loadState(*processor, settings.stateFile))
+            return nullptr;
+
+        auto& parameters = processor->getAPVTS();
+        for (auto& key : settings.parameterValues.getAllKeys())
+            if (! applyParameter(parameters, key, settings.parameterValues[key]))
+                return nullptr;
+
+        processor->setNoiseSeed(seed);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+        layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+        if (! processor->setBusesLayout(layout))
+        {
+            fail("the processor rejected a " + juce::String(numChannels) + "-channel layout");
+            return nullptr;
+        }
+
+        processor->setNonRealtime(true);
+        processor->setRateAndBufferSizeDetails(sampleRate, settings.blockSize);
+        processor->prepareToPlay(sampleRate, settings.blockSize);
+        processor->getProfiler().setEnabled(settings.profile != nullptr);
+        processor->setTracer(settings.trace);
+        return processor;
+    }
+
+    /** Runs stream positions [from, to) through the processor in whole blocks of the
+        buffer's size, starting the noise at `from`. The stream is the input followed
+        by silence. Automation before `from` is applied up front, the rest at its
+        offset in its block. onBlock(position) is called after each block and can stop
+        the run by returning false. */
+    template <typename BlockCallback>
+    bool processRange(LazirkoAudioProcessor& processor, juce::AudioFormatReader& reader,
+                      const std::vector<AutomationEvent>& automation, juce::int64 from, juce::int64 to,
+                      juce::AudioBuffer<float>& buffer, BlockCallback&& onBlock)
+    {
+        const int blockSize = buffer.getNumSamples();
+        juce::MidiBuffer midi;
+
+        processor.setNoisePosition(static_cast<juce::uint64>(from));
+
+        // Only the last value before `from` matters for each parameter
+        auto nextEvent = automation.begin();
+        std::map<juce::String, float> startValues;
+
+        for (; nextEvent != automation.end() && nextEvent->position < from; ++nextEvent)
+            startValues[nextEvent->parameterID] = nextEvent->value;
+
+        for (auto& startValue : startValues)
+            processor.queueParameterChange(startValue.first, startValue.second, 0);
+
+        for (auto position = from; position < to; position += blockSize)
+        {
+            for (; nextEvent != automation.end() && nextEvent->position < position + blockSize; ++nextEvent)
+            {
+                const auto offset = static_cast<int>(nextEvent->position - position);
+
+                if (! processor.queueParameterChange(nextEvent->parameterID, nextEvent->value, offset))
+                    return fail("too many automation points in one block; use a smaller --block-size");
+            }
+
+            buffer.clear();
+
+            const auto numToRead = juce::jmin<juce::int64>(blockSize, reader.lengthInSamples - position);
+            if (numToRead > 0)
+                reader.read(&buffer, 0, static_cast<int>(numToRead), position, true, true);
+
+            processor.processBlock(buffer, midi);
+            midi.clear();
+
+            if (! onBlock(position))
+                return false;
+        }
+
+        return true;
+    }
+
+    /** One slice of a parallel render. The slice keeps stream range `keep`, but starts
+        processing warmUpLength samples earlier so that the filter and gain states have
+        settled by the time its first kept sample comes out. */
+    struct Chunk
+    {
+        juce::Range<juce::int64> keep;
+        juce::int64 processFrom = 0;
+
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        std::unique_ptr<LazirkoAudioProcessor> processor;
+        juce::AudioBuffer<float> output;
+        const std::vector<AutomationEvent>* automation = nullptr;
+
+        juce::WaitableEvent finished;
+        bool succeeded = false;
+    };
+
+    void renderChunk(Chunk& chunk, int blockSize, const std::atomic<bool>& cancelled)
+    {
+        juce::AudioBuffer<float> buffer(chunk.output.getNumChannels(), blockSize);
+
+        chunk.succeeded = processRange(*chunk.processor, *chunk.reader, *chunk.automation,
+                                       chunk.processFrom, chunk.keep.getEnd(), buffer,
+                                       [&] (juce::int64 position)
+                                       {
+                                           const auto overlap = chunk.keep.getIntersectionWith({ position, position + blockSize });
+
+                                           for (int ch = 0; ch < buffer.getNumChannels() && ! overlap.isEmpty(); ++ch)
+                                               chunk.output.copyFrom(ch, static_cast<int>(overlap.getStart() - chunk.keep.getStart()),
+                                                                     buffer, ch, static_cast<int>(overlap.getStart() - position),
+                                                                     static_cast<int>(overlap.getLength()));
+
+                                           return ! cancelled.load();
+                                       });
+
+        chunk.finished.signal();
+    }
+
+    bool renderFile(juce::AudioFormatManager& formats, const juce::File& input, const juce::File& output,
+                    const RenderSettings& settings)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(input));
+        if (reader == nullptr)
+            return fail("can't open " + input.getFullPathName() + " as audio");
+
+        const int numChannels = static_cast<int>(reader->numChannels);
+        if (numChannels < 1 || numChannels > 2)
+            return fail(input.getFileName() + ": only mono and stereo files are supported");
+
+        auto* format = formats.findFormatForFileExtension(output.getFileExtension());
+        if (format == nullptr)
+            return fail("no audio format for " + output.getFileName());
+
+        // Every processor of a parallel render must produce the same noise
+        const juce::uint64 seed = settings.hasSeed ? settings.seed
+                                                   : static_cast<juce::uint64>(juce::Random::getSystemRandom().nextInt64());
+
+        const double sampleRate = reader->sampleRate;
+        const int blockSize = settings.blockSize;
+
+        auto processor = createProcessor(settings, numChannels, sampleRate, seed);
+        if (processor == nullptr)
+            return false;
+
+        std::vector<AutomationEvent> automation;
+        if (! parseAutomation(settings, processor->getAPVTS(), sampleRate, automation))
+            return false;
+
+        // Write next to the target and only replace it once the render is complete
+        output.getParentDirectory().createDirectory();
+        juce::TemporaryFile tempFile(output);
+
+        std::unique_ptr<juce::OutputStream> stream = std::make_unique<juce::FileOutputStream>(tempFile.getFile());
+        if (! static_cast<juce::FileOutputStream*>(stream.get())->openedOk())
+            return fail("can't write to " + output.getFullPathName());
+
+        const int bitDepth = chooseBitDepth(*format, settings.bitDepth > 0 ? settings.bitDepth
+                                                                            : static_cast<int>(reader->bitsPerSample));
+
+        auto writer = format->createWriterFor(stream, juce::AudioFormatWriterOptions{}
+                                                          .withSampleRate(sampleRate)
+                                                          .withNumChannels(numChannels)
+                                                          .withBitsPerSample(bitDepth));
+        if (writer == nullptr)
+            return fail("can't create a " + format->getFormatName() + " writer for " + output.getFileName());
+
+        // The processed stream is the input plus the tail; its first latency samples are dropped
+        const juce::int64 latency = processor->getLatencySamples();
+        const juce::int64 tailLength = juce::roundToInt(juce::jmin(processor->getTailLengthSeconds(), maxTailSeconds)
+                                                        * sampleRate);
+        const juce::Range<juce::int64> kept(latency, latency + reader->lengthInSamples + tailLength);
+
+        auto roundUpToBlocks = [blockSize] (double numSamples)
+        {
+            return (static_cast<juce::int64>(std::ceil(numSamples)) + blockSize - 1) / blockSize * blockSize;
+        };
+
+        const auto usesAutoGain = [&]
+        {
+            if (processor->getAPVTS().getRawParameterValue("AUTOGAIN")->load() >= 0.5f)
+                return true;
+
+            return std::any_of(automation.begin(), automation.end(), [] (const AutomationEvent& event)
+            {
+                return event.parameterID == "AUTOGAIN" && event.value >= 0.5f;
+            });
+        };
+
+        const double settlingSeconds = usesAutoGain() ? LazirkoAudioProcessor::autoGainSettlingSeconds
+                                                      : LazirkoAudioProcessor::settlingSeconds;
+
+        const juce::int64 chunkLength = roundUpToBlocks(chunkSeconds * sampleRate);
+        const juce::int64 warmUpLength = roundUpToBlocks(settlingSeconds * sampleRate);
+
+        if (settings.numThreads <= 1 || kept.getEnd() <= 2 * chunkLength)
+        {
+            juce::AudioBuffer<float> buffer(numChannels, blockSize);
+
+            const bool ok = processRange(*processor, *reader, automation, 0, kept.getEnd(), buffer, [&] (juce::int64 position)
+            {
+                const auto overlap = kept.getIntersectionWith({ position, position + blockSize });
+
+                return overlap.isEmpty()
+                    || writer->writeFromAudioSampleBuffer(buffer, static_cast<int>(overlap.getStart() - position),
+                                                          static_cast<int>(overlap.getLength()));
+            });
+
+            if (! ok)
+                return fail("write error on " + output.getFullPathName());
+
+            if (settings.profile != nullptr)
+                settings.profile->addFrom(processor->getProfiler());
+        }
+        else
+        {
+            // Chunks start on block boundaries of the serial render, so every block sees the
+            // same samples and noise positions it would there. Only a bounded number of
+            // chunks is kept in memory; they are written in order as they complete.
+            processor.reset();   // each chunk gets its own
+
+            const int maxChunksInFlight = settings.numThreads * 2;
+            std::atomic<bool> cancelled { false };
+            std::deque<std::unique_ptr<Chunk>> chunks;
+            juce::ThreadPool pool(settings.numThreads);
+
+            auto cancel = [&]
+            {
+                cancelled = true;
+                for (auto& chunk : chunks)
+                    chunk->finished.wait();
+            };
+
+            juce::int64 nextChunkStart = 0;
+
+            while (nextChunkStart < kept.getEnd() || ! chunks.empty())
+            {
+                while (nextChunkStart < kept.getEnd() && static_cast<int>(chunks.size()) < maxChunksInFlight)
+                {
+                    const auto keep = kept.getIntersectionWith({ nextChunkStart, nextChunkStart + chunkLength });
+                    const auto processFrom = juce::jmax<juce::int64>(0, nextChunkStart - warmUpLength);
+                    nextChunkStart += chunkLength;
+
+                    if (keep.isEmpty())
+                        continue;
+
+                    auto chunk = std::make_unique<Chunk>();
+                    chunk->keep = keep;
+                    chunk->processFrom = processFrom;
+                    chunk->automation = &automation;
+                    chunk->reader.reset(formats.createReaderFor(input));
+                    chunk->processor = createProcessor(settings, numChannels, sampleRate, seed);
+
+                    if (chunk->reader == nullptr || chunk->processor == nullptr)
+                    {
+                        cancel();
+                        return fail("can't set up a render thread for " + input.getFileName());
+                    }
+
+                    chunk->output.setSize(numChannels, static_cast<int>(chunk->keep.getLength()));
+
+                    auto* job = chunk.get();
+                    chunks.push_back(std::move(chunk));
+                    pool.addJob([job, blockSize, &cancelled] { renderChunk(*job, blockSize, cancelled); });
+                }
+
+                if (chunks.empty())
+                    continue;
+
+                auto& head = *chunks.front();
+                head.finished.wait();
+
+                if (! head.succeeded || ! writer->writeFromAudioSampleBuffer(head.output, 0, head.output.getNumSamples()))
+                {
+                    cancel();
+                    return fail("write error on " + output.getFullPathName());
+                }
+
+                if (settings.profile != nullptr)
+                    settings.profile->addFrom(head.processor->getProfiler());
+
+                chunks.pop_front();
+            }
+        }
+
+        writer.reset();
+
+        if (! tempFile.overwriteTargetFileWithTemporary())
+            return fail("can't replace " + output.getFullPathName());
+
+        std::cout << input.getFileName() << " -> " << output.getFullPathName()
+                  << " (" << kept.getLength() << " samples)" << std::endl;
+        return true;
+    }
+
+    // Maps the convenience flags onto parameter IDs
+    juce::String getParameterIDForOption(const juce::String& option)
+    {
+        if (option == "--mode")      return "MODE";
+        if (option == "--dephase")   return "DEPHASE";
+        if (option == "--damping")   return "DAMPING";
+        if (option == "--mix")       return "MIX";
+        if (option == "--autogain")  return "AUTOGAIN";
+        if (option == "--oversampling")         return "OVERSAMPLING";
+        if (option == "--oversampling-filter")  return "OVERSAMPLING_FILTER";
+        if (option == "--quality")              return "QUALITY";
+        return {};
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::CharPointer_UTF8(argv[i]));
+
+    RenderSettings settings;
+    settings.numThreads = juce::SystemStats::getNumCpus();
+
+    juce::File outputDir;
+    juce::File profileFile;
+    juce::File traceFile;
+    juce::StringArray positional;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+
+        if (! arg.startsWith("--"))
+        {
+            positional.add(arg);
+            continue;
+        }
+
+        if (i + 1 >= args.size())
+        {
+            fail("missing value for " + arg);
+            return 1;
+        }
+
+        const auto value = args[++i];
+
+        if (auto parameterID = getParameterIDForOption(arg); parameterID.isNotEmpty())
+            settings.parameterValues.set(parameterID, value);
+        else if (arg == "--set" && value.containsChar('='))
+            settings.parameterValues.set(value.upToFirstOccurrenceOf("=", false, false).trim().toUpperCase(),
+                                         value.fromFirstOccurrenceOf("=", false, false).trim());
+        else if (arg == "--automate" && value.containsChar('='))
+            settings.automation.set(value.upToFirstOccurrenceOf("=", false, false).trim().toUpperCase(),
+                                    value.fromFirstOccurrenceOf("=", false, false).trim());
+        else if (arg == "--state")
+            settings.stateFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (arg == "--seed")
+            { settings.seed = static_cast<juce::uint64>(value.getLargeIntValue()); settings.hasSeed = true; }
+        else if (arg == "--block-size")
+            settings.blockSize = juce::jlimit(32, 1 << 20, value.getIntValue());
+        else if (arg == "--bits")
+            settings.bitDepth = value.getIntValue();
+        else if (arg == "--threads")
+            settings.numThreads = juce::jmax(1, value.getIntValue());
+        else if (arg == "--output-dir")
+            outputDir = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (arg == "--profile")
+            profileFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (arg == "--trace")
+            traceFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else
+        {
+            fail("unknown option " + arg + " " + value);
+            return 1;
+        }
+    }
+
+    const auto cwd = juce::File::getCurrentWorkingDirectory();
+
+    juce::Array<std::pair<juce::File, juce::File>> jobs;
+
+    if (outputDir != juce::File())
+    {
+        for (auto& path : positional)
+        {
+            auto input = cwd.getChildFile(path);
+            jobs.add({ input, outputDir.getChildFile(input.getFileName()) });
+        }
+    }
+    else if (positional.size() == 2)
+    {
+        jobs.add({ cwd.getChildFile(positional[0]), cwd.getChildFile(positional[1]) });
+    }
+
+    if (jobs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    // One report over all files; a render that is not real-time still shows how far
+    // ahead of real time each stage runs
+    CpuProfiler profile;
+    if (profileFile != juce::File())
+        settings.profile = &profile;
+
+    // One timeline too, with a track for every thread that rendered
+    TraceRecorder trace;
+    if (traceFile != juce::File())
+    {
+        if (! trace.start(traceFile))
+        {
+            fail("can't write " + traceFile.getFullPathName());
+            return 1;
+        }
+
+        settings.trace = &trace;
+    }
+
+    int numFailed = 0;
+    for (auto& job : jobs)
+        if (! renderFile(formats, job.first, job.second, settings))
+            ++numFailed;
+
+    if (settings.profile != nullptr && ! profileFile.replaceWithText(profile.getReportText()))
+    {
+        fail("can't write " + profileFile.getFullPathName());
+        ++numFailed;
+    }
+
+    if (settings.trace != nullptr)
+    {
+        trace.stop();
+
+        // Renders run faster than real time and can outpace the trace writer
+        if (const int numDropped = trace.getNumDroppedEvents(); numDropped > 0)
+            std::cerr << "LazirkoRender: " << numDropped << " trace events dropped" << std::endl;
+    }
+
+    return numFailed == 0 ? 0 : 1;
+}